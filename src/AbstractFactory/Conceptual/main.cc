@@ -1,6 +1,8 @@
 #include <iostream>
 #include <string>
 
+#include "../../Benchmark/benchmark.h"
+
 /**
  * EN: Abstract Factory Design Pattern
  *
@@ -196,7 +198,40 @@ void ClientCode(const AbstractFactory &factory) {
   delete product_b;
 }
 
-int main() {
+/**
+ * EN: Run with `--benchmark` to time the client code with each factory, which
+ * creates both products, uses them and deletes them. The output is thrown
+ * away.
+ *
+ * RU: Запустите с `--benchmark`, чтобы замерить клиентский код с каждой
+ * фабрикой: он создаёт оба продукта, использует их и удаляет. Вывод
+ * отбрасывается.
+ */
+void Benchmark(benchmark::Harness &harness) {
+  const int calls = 1000000;
+  ConcreteFactory1 f1;
+  ConcreteFactory2 f2;
+  harness.Run("ClientCode with ConcreteFactory1", calls, [&] {
+    benchmark::MuteOutput mute;
+    for (int i = 0; i < calls; ++i) {
+      ClientCode(f1);
+    }
+  });
+  harness.Run("ClientCode with ConcreteFactory2", calls, [&] {
+    benchmark::MuteOutput mute;
+    for (int i = 0; i < calls; ++i) {
+      ClientCode(f2);
+    }
+  });
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1 && std::string(argv[1]) == "--benchmark") {
+    benchmark::Harness harness(argc, argv);
+    Benchmark(harness);
+    return harness.Finish();
+  }
+
   std::cout << "Client: Testing client code with the first factory type:\n";
   ConcreteFactory1 *f1 = new ConcreteFactory1();
   ClientCode(*f1);
@@ -1,6 +1,15 @@
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
 
 /**
  * EN: Adapter Design Pattern
@@ -44,6 +53,191 @@ class Adaptee {
   }
 };
 
+/**
+ * EN: The translation the Adapter performs is a byte reversal, which is worth
+ * doing well when the payloads are large. ReverseBytes writes the reversed
+ * input straight into the caller's output, 16 bytes at a time with SSE2
+ * shuffles (part of every x86-64 CPU, so no runtime check is needed), and
+ * byte by byte elsewhere and for the remainder.
+ *
+ * Reversing bytes would scramble the multibyte sequences of UTF-8 text.
+ * ReverseUtf8 reverses the bytes first and then puts every multibyte sequence
+ * back in order. ASCII, which needs no repair, is skipped 8 bytes at a time.
+ *
+ * RU: Перевод, который выполняет Адаптер, — это разворот байтов, и его стоит
+ * делать хорошо, когда данные большие. ReverseBytes пишет развёрнутый вход
+ * прямо в выходной буфер вызывающего кода, по 16 байтов за раз с помощью
+ * перестановок SSE2 (они есть в каждом процессоре x86-64, так что проверка во
+ * время выполнения не нужна), а на других платформах и для остатка — побайтово.
+ *
+ * Разворот байтов перепутал бы многобайтовые последовательности текста в UTF-8.
+ * ReverseUtf8 сначала разворачивает байты, а затем возвращает каждую
+ * многобайтовую последовательность в правильный порядок. ASCII, который не
+ * нужно исправлять, пропускается по 8 байтов за раз.
+ */
+void ReverseBytes(const char *source, std::size_t size, char *destination) {
+  std::size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+  for (; i + 16 <= size; i += 16) {
+    __m128i block =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i));
+    block = _mm_shuffle_epi32(block, _MM_SHUFFLE(0, 1, 2, 3));
+    block = _mm_shufflelo_epi16(block, _MM_SHUFFLE(2, 3, 0, 1));
+    block = _mm_shufflehi_epi16(block, _MM_SHUFFLE(2, 3, 0, 1));
+    block = _mm_or_si128(_mm_slli_epi16(block, 8), _mm_srli_epi16(block, 8));
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i *>(destination + size - i - 16), block);
+  }
+#endif
+  for (; i < size; ++i) {
+    destination[size - i - 1] = source[i];
+  }
+}
+
+void ReverseUtf8(const char *source, std::size_t size, char *destination) {
+  ReverseBytes(source, size, destination);
+  std::size_t i = 0;
+  while (i < size) {
+    if (i + 8 <= size) {
+      std::uint64_t word;
+      std::memcpy(&word, destination + i, 8);
+      if ((word & 0x8080808080808080ULL) == 0) {
+        i += 8;
+        continue;
+      }
+    }
+    // EN: A reversed sequence is its continuation bytes (10xxxxxx) followed
+    // by its lead byte.
+    //
+    // RU: Развёрнутая последовательность — это её байты продолжения (10xxxxxx),
+    // за которыми следует её ведущий байт.
+    std::size_t end = i;
+    while (end < size &&
+           (static_cast<unsigned char>(destination[end]) & 0xC0) == 0x80) {
+      ++end;
+    }
+    if (end > i && end < size) {
+      std::reverse(destination + i, destination + end + 1);
+      i = end + 1;
+    } else {
+      i = end > i ? end : i + 1;
+    }
+  }
+}
+
+const char kTranslatedPrefix[] = "Adapter: (TRANSLATED) ";
+const std::size_t kTranslatedPrefixSize = sizeof(kTranslatedPrefix) - 1;
+
+/**
+ * EN: Translated responses packed back to back into one arena. Response i
+ * occupies [offsets[i], offsets[i + 1]) of `text`, so a batch costs two
+ * buffers however many responses it holds, and reusing a batch costs none.
+ *
+ * RU: Переведённые ответы, уложенные вплотную друг за другом в одну арену.
+ * Ответ i занимает [offsets[i], offsets[i + 1]) в `text`, так что пакет стоит
+ * двух буферов, сколько бы ответов он ни содержал, а повторное использование
+ * пакета не стоит ничего.
+ */
+struct TranslatedBatch {
+  std::string text;
+  std::vector<std::size_t> offsets;
+
+  std::size_t size() const {
+    return offsets.empty() ? 0 : offsets.size() - 1;
+  }
+  const char *data(std::size_t i) const {
+    return text.data() + offsets[i];
+  }
+  std::size_t length(std::size_t i) const {
+    return offsets[i + 1] - offsets[i];
+  }
+};
+
+const std::size_t kViewChunk = 256;
+
+/**
+ * EN: A translation that is never materialised. The view keeps the Adaptee's
+ * response as it came and maps every read position onto it, so a client that
+ * looks at the first few bytes pays for those bytes only. Positions count
+ * bytes of the translated text, which for valid UTF-8 is byte for byte what
+ * Request() returns.
+ *
+ * RU: Перевод, который никогда не материализуется целиком. Представление
+ * хранит ответ Адаптируемого класса как есть и отображает на него каждую
+ * позицию чтения, так что клиент, читающий первые несколько байтов, платит
+ * только за них. Позиции считаются в байтах переведённого текста, который для
+ * корректного UTF-8 байт в байт совпадает с результатом Request().
+ */
+class TranslatedView {
+ private:
+  std::string source_;
+
+ public:
+  explicit TranslatedView(std::string source) : source_(std::move(source)) {}
+
+  std::size_t Size() const {
+    return kTranslatedPrefixSize + source_.size();
+  }
+  char At(std::size_t i) const {
+    char c = '\0';
+    Copy(i, 1, &c);
+    return c;
+  }
+  /**
+   * EN: Copies up to `count` bytes starting at `pos` into `out` and returns
+   * how many were copied.
+   *
+   * RU: Копирует до `count` байтов, начиная с `pos`, в `out` и возвращает
+   * количество скопированных байтов.
+   */
+  std::size_t Copy(std::size_t pos, std::size_t count, char *out) const {
+    if (pos >= Size()) {
+      return 0;
+    }
+    count = std::min(count, Size() - pos);
+    std::size_t copied = 0;
+    if (pos < kTranslatedPrefixSize) {
+      copied = std::min(count, kTranslatedPrefixSize - pos);
+      std::memcpy(out, kTranslatedPrefix + pos, copied);
+    }
+    // EN: The bytes wanted end `offset` bytes before the end of the source.
+    // UTF-8 is self-synchronising, so widening each slice to whole sequences
+    // and reversing it on the stack yields exactly the bytes of Request().
+    //
+    // RU: Нужные байты заканчиваются за `offset` байтов до конца источника.
+    // UTF-8 самосинхронизируется, поэтому расширение каждого среза до целых
+    // последовательностей и его разворот на стеке дают ровно те же байты, что и
+    // Request().
+    std::size_t offset = pos + copied - kTranslatedPrefixSize;
+    while (copied < count) {
+      const std::size_t chunk = std::min(count - copied, kViewChunk);
+      const std::size_t high = source_.size() - offset;
+      const std::size_t low = high - chunk;
+      std::size_t wide_high = high;
+      while (wide_high < source_.size() && wide_high - high < 3 &&
+             IsContinuation(source_[wide_high])) {
+        ++wide_high;
+      }
+      std::size_t wide_low = low;
+      while (wide_low > 0 && low - wide_low < 3 &&
+             IsContinuation(source_[wide_low])) {
+        --wide_low;
+      }
+      char reversed[kViewChunk + 6];
+      ReverseUtf8(source_.data() + wide_low, wide_high - wide_low, reversed);
+      std::memcpy(out + copied, reversed + (wide_high - high), chunk);
+      copied += chunk;
+      offset += chunk;
+    }
+    return count;
+  }
+
+ private:
+  static bool IsContinuation(char c) {
+    return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+  }
+};
+
 /**
  * EN: The Adapter makes the Adaptee's interface compatible with the Target's
  * interface using multiple inheritance.
@@ -56,8 +250,50 @@ class Adapter : public Target, public Adaptee {
   Adapter() {}
   std::string Request() const override {
     std::string to_reverse = SpecificRequest();
-    std::reverse(to_reverse.begin(), to_reverse.end());
-    return "Adapter: (TRANSLATED) " + to_reverse;
+    std::string result(kTranslatedPrefixSize + to_reverse.size(), '\0');
+    Translate(to_reverse, &result[0]);
+    return result;
+  }
+
+  /**
+   * EN: The same translation as Request(), but read lazily through a view.
+   *
+   * RU: Тот же перевод, что и у Request(), но читаемый лениво через
+   * представление.
+   */
+  TranslatedView View() const {
+    return TranslatedView(SpecificRequest());
+  }
+
+  /**
+   * EN: Translates `count` Adaptee responses into `batch` without going
+   * through Request() for each one: the arena is sized once up front and
+   * every translation is written straight into its slot.
+   *
+   * RU: Переводит `count` ответов Адаптируемого класса в `batch`, не проходя
+   * через Request() для каждого из них: арена получает нужный размер один раз
+   * заранее, и каждый перевод пишется прямо на своё место.
+   */
+  static void TranslateBatch(const std::string *responses, std::size_t count,
+                             TranslatedBatch &batch) {
+    batch.offsets.resize(count + 1);
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+      batch.offsets[i] = total;
+      total += kTranslatedPrefixSize + responses[i].size();
+    }
+    batch.offsets[count] = total;
+    batch.text.resize(total);
+    for (std::size_t i = 0; i < count; ++i) {
+      Translate(responses[i], &batch.text[0] + batch.offsets[i]);
+    }
+  }
+
+ private:
+  static void Translate(const std::string &response, char *destination) {
+    std::memcpy(destination, kTranslatedPrefix, kTranslatedPrefixSize);
+    ReverseUtf8(response.data(), response.size(),
+                destination + kTranslatedPrefixSize);
   }
 };
 
@@ -82,7 +318,22 @@ int main() {
   std::cout << "Client: But I can work with it via the Adapter:\n";
   Adapter *adapter = new Adapter;
   ClientCode(adapter);
+  std::cout << "\n\n";
+  std::cout << "Client: Whole batches of responses can be translated at once:\n";
+  std::vector<std::string> responses;
+  responses.push_back(adaptee->SpecificRequest());
+  responses.push_back(".hctab a ni eetpadA eht morF");
+  TranslatedBatch batch;
+  Adapter::TranslateBatch(responses.data(), responses.size(), batch);
+  for (std::size_t i = 0; i < batch.size(); ++i) {
+    std::cout.write(batch.data(i), batch.length(i)) << "\n";
+  }
   std::cout << "\n";
+  std::cout << "Client: And I can read just the start of a translation:\n";
+  TranslatedView view = adapter->View();
+  char start[29];
+  std::size_t length = view.Copy(0, sizeof(start), start);
+  std::cout.write(start, length) << "...\n";
 
   delete target;
   delete adaptee;
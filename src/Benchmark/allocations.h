@@ -0,0 +1,377 @@
+#ifndef BENCHMARK_ALLOCATIONS_H_
+#define BENCHMARK_ALLOCATIONS_H_
+
+/**
+ * EN: Allocation tracker
+ *
+ * Replaces the global operator new and operator delete so that allocations can
+ * be counted. Counting happens only inside an AllocationPhase, a named scope
+ * that collects the number of allocations, their bytes and the call sites they
+ * came from:
+ *
+ *   {
+ *     benchmark::AllocationPhase phase("build tree", 1000);
+ *     ... 1000 operations ...
+ *     phase.Report(std::cout);
+ *   }
+ *
+ * Nothing includes this header by default. Benchmarks opt in by building with
+ * -DBENCHMARK_TRACK_ALLOCATIONS: every Harness::Run() then becomes a phase
+ * and reports allocations per operation, and Harness::Budget() limits them.
+ *
+ * Phases count the allocations of every thread, and they nest: the innermost
+ * one is counted. A phase that ends waits for the operators that other threads
+ * are running on it, so it is never used after it is gone. A call site is the
+ * few innermost frames of the allocation, which glibc's backtrace() provides.
+ * Build with -rdynamic to see the function names in them, or pass the addresses
+ * to addr2line. A program may replace the operators only once, which suits the
+ * single-file examples.
+ *
+ * RU: Счётчик выделений памяти
+ *
+ * Заменяет глобальные operator new и operator delete, чтобы выделения памяти
+ * можно было подсчитать. Подсчёт идёт только внутри AllocationPhase —
+ * именованной области, которая собирает число выделений, их размер в байтах и
+ * места вызова, из которых они пришли (см. пример выше).
+ *
+ * По умолчанию этот заголовок никто не подключает. Бенчмарки включают его
+ * сборкой с -DBENCHMARK_TRACK_ALLOCATIONS: тогда каждый Harness::Run()
+ * становится фазой и сообщает число выделений на операцию, а Harness::Budget()
+ * ограничивает их.
+ *
+ * Фазы считают выделения всех потоков и могут быть вложенными: учитывается
+ * самая внутренняя. Завершающаяся фаза дожидается операторов, которые другие
+ * потоки выполняют с ней, поэтому она никогда не используется после своего
+ * уничтожения. Место вызова — это несколько самых внутренних кадров стека
+ * выделения, которые предоставляет backtrace() из glibc. Соберите программу с
+ * -rdynamic, чтобы увидеть в них имена функций, или передайте адреса addr2line.
+ * Программа может заменить эти операторы только один раз, что подходит для
+ * примеров из одного файла.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <execinfo.h>
+#define BENCHMARK_HAS_BACKTRACE 1
+#endif
+
+#if defined(__GNUC__)
+#define BENCHMARK_NOINLINE __attribute__((noinline))
+#else
+#define BENCHMARK_NOINLINE
+#endif
+
+namespace benchmark {
+
+/**
+ * EN: Where allocations came from, innermost frame first.
+ *
+ * RU: Откуда пришли выделения памяти, начиная с самого внутреннего кадра.
+ */
+struct CallSite {
+  std::string frames;
+  std::uint64_t allocations = 0;
+  std::uint64_t bytes = 0;
+};
+
+class AllocationPhase {
+ private:
+  static const int kDepth = 4;
+  static const int kSites = 64;
+
+  struct Site {
+    void *frames[kDepth];
+    std::uint64_t allocations;
+    std::uint64_t bytes;
+  };
+
+  std::string name_;
+  std::size_t operations_;
+  AllocationPhase *previous_;
+  std::atomic<std::uint64_t> allocations_;
+  std::atomic<std::uint64_t> bytes_;
+  std::atomic<std::uint64_t> deallocations_;
+  mutable std::mutex sites_mutex_;
+  Site sites_[kSites];
+  int site_count_ = 0;
+
+ public:
+  explicit AllocationPhase(std::string name, std::size_t operations = 1)
+      : name_(std::move(name)),
+        operations_(operations == 0 ? 1 : operations),
+        previous_(CurrentSlot().load()),
+        allocations_(0),
+        bytes_(0),
+        deallocations_(0) {
+    CurrentSlot().store(this);
+  }
+  ~AllocationPhase() {
+    std::lock_guard<std::mutex> lock(EndMutex());
+    CurrentSlot().store(previous_);
+    // EN: Operators that picked this phase before it was replaced registered
+    // under the current epoch. Flipping the epoch sends new ones to the other
+    // counter, so the one waited on can drain; twice, since an operator may
+    // have read the epoch just before a flip.
+    //
+    // RU: Операторы, выбравшие эту фазу до того, как её сменили,
+    // зарегистрировались в текущей эпохе. Смена эпохи направляет новые
+    // операторы к другому счётчику, так что тот, которого ждут, может опустеть;
+    // дважды, поскольку оператор мог прочитать эпоху прямо перед сменой.
+    for (int flip = 0; flip < 2; ++flip) {
+      unsigned epoch = Epoch().fetch_add(1);
+      while (Recorders()[epoch & 1].load() != 0) {
+        std::this_thread::yield();
+      }
+    }
+  }
+  AllocationPhase(const AllocationPhase &) = delete;
+  AllocationPhase &operator=(const AllocationPhase &) = delete;
+
+  static AllocationPhase *Current() {
+    return CurrentSlot().load(std::memory_order_acquire);
+  }
+
+  const std::string &Name() const {
+    return name_;
+  }
+  std::uint64_t Allocations() const {
+    return allocations_.load();
+  }
+  std::uint64_t Bytes() const {
+    return bytes_.load();
+  }
+  std::uint64_t Deallocations() const {
+    return deallocations_.load();
+  }
+  double AllocationsPerOperation() const {
+    return static_cast<double>(Allocations()) / operations_;
+  }
+  double BytesPerOperation() const {
+    return static_cast<double>(Bytes()) / operations_;
+  }
+
+  /**
+   * EN: The call sites with the most allocations, at most `limit` of them.
+   * Sites beyond the first 64 are lumped together without frames.
+   *
+   * RU: Места вызова с наибольшим числом выделений, не более `limit` штук.
+   * Места сверх первых 64 объединяются в одно, без кадров.
+   */
+  std::vector<CallSite> CallSites(std::size_t limit) const {
+    Untracked untracked;
+    std::vector<CallSite> sites;
+    std::lock_guard<std::mutex> lock(sites_mutex_);
+    std::uint64_t known = 0;
+    for (int i = 0; i < site_count_; ++i) {
+      CallSite site;
+      site.frames = Describe(sites_[i].frames);
+      site.allocations = sites_[i].allocations;
+      site.bytes = sites_[i].bytes;
+      known += site.allocations;
+      sites.push_back(site);
+    }
+    if (site_count_ == kSites && known < Allocations()) {
+      CallSite other;
+      other.frames = "(other call sites)";
+      other.allocations = Allocations() - known;
+      sites.push_back(other);
+    }
+    std::sort(sites.begin(), sites.end(),
+              [](const CallSite &a, const CallSite &b) {
+                return a.allocations > b.allocations;
+              });
+    if (sites.size() > limit) {
+      sites.resize(limit);
+    }
+    return sites;
+  }
+
+  void Report(std::ostream &out, std::size_t limit = 3) const {
+    Untracked untracked;
+    out << name_ << ": " << AllocationsPerOperation() << " allocations ("
+        << BytesPerOperation() << " bytes) per operation\n";
+    for (const CallSite &site : CallSites(limit)) {
+      out << "    " << site.allocations << " allocations, " << site.bytes
+          << " bytes: " << site.frames << "\n";
+    }
+  }
+
+  /**
+   * EN: Called by the replaced operators; not meant for anything else.
+   *
+   * RU: Вызывается заменёнными операторами; ни для чего другого не
+   * предназначена.
+   */
+  BENCHMARK_NOINLINE void RecordAllocation(std::size_t size) {
+    allocations_.fetch_add(1, std::memory_order_relaxed);
+    bytes_.fetch_add(size, std::memory_order_relaxed);
+#if defined(BENCHMARK_HAS_BACKTRACE)
+    // EN: The first two frames are this function and operator new.
+    //
+    // RU: Первые два кадра — это сама эта функция и operator new.
+    void *frames[kDepth + 2] = {};
+    backtrace(frames, kDepth + 2);
+    std::lock_guard<std::mutex> lock(sites_mutex_);
+    for (int i = 0; i < site_count_; ++i) {
+      if (std::equal(frames + 2, frames + 2 + kDepth, sites_[i].frames)) {
+        ++sites_[i].allocations;
+        sites_[i].bytes += size;
+        return;
+      }
+    }
+    if (site_count_ < kSites) {
+      Site &site = sites_[site_count_++];
+      std::copy(frames + 2, frames + 2 + kDepth, site.frames);
+      site.allocations = 1;
+      site.bytes = size;
+    }
+#endif
+  }
+  void RecordDeallocation() {
+    deallocations_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * EN: Held by the replaced operators while they use the current phase, which
+   * keeps that phase from ending until they are done with it.
+   *
+   * RU: Удерживается заменёнными операторами, пока они используют текущую фазу,
+   * и не даёт этой фазе завершиться, пока они с ней не закончат.
+   */
+  class Recording {
+   private:
+    std::atomic<std::size_t> &counter_;
+    AllocationPhase *phase_;
+
+   public:
+    Recording() : counter_(Recorders()[Epoch().load() & 1]) {
+      counter_.fetch_add(1);
+      phase_ = CurrentSlot().load();
+    }
+    ~Recording() {
+      counter_.fetch_sub(1);
+    }
+    Recording(const Recording &) = delete;
+    Recording &operator=(const Recording &) = delete;
+
+    AllocationPhase *Phase() const {
+      return phase_;
+    }
+  };
+
+  /**
+   * EN: While one of these is alive, the current thread's allocations are not
+   * counted. The tracker uses it for its own bookkeeping.
+   *
+   * RU: Пока такой объект жив, выделения памяти текущего потока не
+   * подсчитываются. Счётчик использует его для собственного учёта.
+   */
+  class Untracked {
+   private:
+    bool previous_;
+
+   public:
+    Untracked() : previous_(Busy()) {
+      Busy() = true;
+    }
+    ~Untracked() {
+      Busy() = previous_;
+    }
+  };
+
+  static bool &Busy() {
+    static thread_local bool busy = false;
+    return busy;
+  }
+
+ private:
+  static std::atomic<AllocationPhase *> &CurrentSlot() {
+    static std::atomic<AllocationPhase *> current(nullptr);
+    return current;
+  }
+
+  static std::atomic<unsigned> &Epoch() {
+    static std::atomic<unsigned> epoch(0);
+    return epoch;
+  }
+
+  static std::atomic<std::size_t> (&Recorders())[2] {
+    static std::atomic<std::size_t> recorders[2] = {};
+    return recorders;
+  }
+
+  static std::mutex &EndMutex() {
+    static std::mutex mutex;
+    return mutex;
+  }
+
+  static std::string Describe(void *const *frames) {
+    std::string description;
+#if defined(BENCHMARK_HAS_BACKTRACE)
+    int depth = 0;
+    while (depth < kDepth && frames[depth] != nullptr) {
+      ++depth;
+    }
+    char **symbols = backtrace_symbols(frames, depth);
+    for (int i = 0; i < depth; ++i) {
+      description += i == 0 ? "" : " < ";
+      description += symbols != nullptr ? symbols[i] : "?";
+    }
+    std::free(symbols);
+#else
+    (void)frames;
+    description = "(call sites need glibc)";
+#endif
+    return description;
+  }
+};
+
+}  // namespace benchmark
+
+BENCHMARK_NOINLINE void *operator new(std::size_t size) {
+  if (benchmark::AllocationPhase::Current() != nullptr &&
+      !benchmark::AllocationPhase::Busy()) {
+    benchmark::AllocationPhase::Recording recording;
+    if (recording.Phase() != nullptr) {
+      benchmark::AllocationPhase::Untracked untracked;
+      recording.Phase()->RecordAllocation(size);
+    }
+  }
+  void *pointer;
+  while ((pointer = std::malloc(size == 0 ? 1 : size)) == nullptr) {
+    std::new_handler handler = std::get_new_handler();
+    if (handler == nullptr) {
+      throw std::bad_alloc();
+    }
+    handler();
+  }
+  return pointer;
+}
+
+void operator delete(void *pointer) noexcept {
+  if (pointer != nullptr && benchmark::AllocationPhase::Current() != nullptr &&
+      !benchmark::AllocationPhase::Busy()) {
+    benchmark::AllocationPhase::Recording recording;
+    if (recording.Phase() != nullptr) {
+      recording.Phase()->RecordDeallocation();
+    }
+  }
+  std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept {
+  ::operator delete(pointer);
+}
+
+#endif  // BENCHMARK_ALLOCATIONS_H_
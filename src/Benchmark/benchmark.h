@@ -0,0 +1,489 @@
+#ifndef BENCHMARK_BENCHMARK_H_
+#define BENCHMARK_BENCHMARK_H_
+
+/**
+ * EN: Micro-benchmark harness
+ *
+ * The examples keep their benchmarks next to the code they measure, behind a
+ * `--benchmark` flag, so that their normal output stays the same as in
+ * Output.txt. This header is what those benchmarks share. It needs nothing
+ * but the standard library and is included like this:
+ *
+ *   #include "../../Benchmark/benchmark.h"
+ *
+ *   benchmark::Harness harness(argc, argv);
+ *   harness.Run("Request", 1000, [&] {
+ *     for (int i = 0; i < 1000; ++i) {
+ *       benchmark::DoNotOptimize(adapter.Request());
+ *     }
+ *   });
+ *   return harness.Finish();
+ *
+ * Every Run() executes the function once to warm up and then `repetitions`
+ * more times, and reports the mean time per operation, its variance across the
+ * repetitions and the operations per second. On Linux, it also reads cycles,
+ * instructions, cache misses and branch misses through perf_event_open. Where
+ * the counters cannot be opened (other systems, containers, a strict
+ * perf_event_paranoid), they are reported as missing and timing still works.
+ *
+ * Command line: `--json` prints one JSON document from Finish() instead of a
+ * line of text per Run(), and `--repetitions N` changes the default of 5.
+ * Build with optimisations, e.g. `g++ -O2 -std=c++17 -pthread main.cc`.
+ *
+ * Add -DBENCHMARK_TRACK_ALLOCATIONS to count allocations per operation as
+ * well (see allocations.h). Counting slows allocations down, so compare times
+ * only between builds that agree on it.
+ *
+ * RU: Обвязка для микробенчмарков
+ *
+ * Примеры держат свои бенчмарки рядом с кодом, который они измеряют, за флагом
+ * `--benchmark`, чтобы их обычный вывод оставался таким же, как в Output.txt.
+ * Этот заголовок — то, что эти бенчмарки используют совместно. Ему не нужно
+ * ничего, кроме стандартной библиотеки, и он подключается так, как показано
+ * выше.
+ *
+ * Каждый Run() выполняет функцию один раз для разогрева, а затем ещё
+ * `repetitions` раз, и сообщает среднее время на операцию, его дисперсию по
+ * повторениям и число операций в секунду. В Linux он также читает такты,
+ * инструкции, промахи кэша и ошибки предсказания переходов через
+ * perf_event_open. Там, где счётчики открыть нельзя (другие системы,
+ * контейнеры, строгий perf_event_paranoid), они отмечаются как отсутствующие, а
+ * замер времени продолжает работать.
+ *
+ * Командная строка: `--json` печатает из Finish() один документ JSON вместо
+ * строки текста на каждый Run(), а `--repetitions N` меняет значение по
+ * умолчанию, равное 5. Собирайте с оптимизациями, например
+ * `g++ -O2 -std=c++17 -pthread main.cc`.
+ *
+ * Добавьте -DBENCHMARK_TRACK_ALLOCATIONS, чтобы подсчитывать ещё и выделения
+ * памяти на операцию (см. allocations.h). Подсчёт замедляет выделения, поэтому
+ * сравнивайте время только между сборками, которые в этом совпадают.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(BENCHMARK_TRACK_ALLOCATIONS)
+#include "allocations.h"
+#endif
+
+namespace benchmark {
+
+/**
+ * EN: Keeps the compiler from discarding a result that is never used.
+ *
+ * RU: Не даёт компилятору отбросить результат, который нигде не используется.
+ */
+template <typename T>
+inline void DoNotOptimize(const T &value) {
+#if defined(__GNUC__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile const void *sink;
+  sink = &value;
+#endif
+}
+
+/**
+ * EN: Hardware counters for one measured interval.
+ *
+ * RU: Аппаратные счётчики за один измеренный интервал.
+ */
+struct Counters {
+  std::uint64_t cycles = 0;
+  std::uint64_t instructions = 0;
+  std::uint64_t cache_misses = 0;
+  std::uint64_t branch_misses = 0;
+};
+
+/**
+ * EN: The four counters, opened as one perf_event group so that they are
+ * started, stopped and read together. Only user-space events are counted,
+ * which is what an unprivileged process may count by default.
+ *
+ * RU: Четыре счётчика, открытые как одна группа perf_event, чтобы они
+ * запускались, останавливались и читались вместе. Подсчитываются только события
+ * пространства пользователя: именно их непривилегированный процесс может
+ * считать по умолчанию.
+ */
+class PerfCounters {
+ private:
+  static const int kEvents = 4;
+  int fds_[kEvents];
+
+ public:
+  PerfCounters() {
+    for (int i = 0; i < kEvents; ++i) {
+      fds_[i] = -1;
+    }
+#if defined(__linux__)
+    const std::uint64_t configs[kEvents] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+    for (int i = 0; i < kEvents; ++i) {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.size = sizeof(attr);
+      attr.config = configs[i];
+      attr.disabled = i == 0;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP;
+      fds_[i] = static_cast<int>(
+          syscall(SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : fds_[0], 0));
+      if (fds_[i] < 0) {
+        Close();
+        return;
+      }
+    }
+#endif
+  }
+  ~PerfCounters() {
+    Close();
+  }
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+  bool Available() const {
+    return fds_[0] >= 0;
+  }
+  void Start() {
+#if defined(__linux__)
+    if (Available()) {
+      ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+      ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+  }
+  Counters Stop() {
+    Counters counters;
+#if defined(__linux__)
+    if (Available()) {
+      ioctl(fds_[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+      std::uint64_t values[1 + kEvents];
+      if (read(fds_[0], values, sizeof(values)) ==
+          static_cast<ssize_t>(sizeof(values))) {
+        counters.cycles = values[1];
+        counters.instructions = values[2];
+        counters.cache_misses = values[3];
+        counters.branch_misses = values[4];
+      }
+    }
+#endif
+    return counters;
+  }
+
+ private:
+  void Close() {
+    for (int i = kEvents - 1; i >= 0; --i) {
+#if defined(__linux__)
+      if (fds_[i] >= 0) {
+        close(fds_[i]);
+      }
+#endif
+      fds_[i] = -1;
+    }
+  }
+};
+
+/**
+ * EN: What Run() measured. Times are per operation and averaged over the
+ * repetitions; the counters are per operation over all of them.
+ *
+ * RU: То, что измерил Run(). Время указано на операцию и усреднено по
+ * повторениям; счётчики указаны на операцию по всем повторениям вместе.
+ */
+struct Result {
+  std::string name;
+  std::size_t operations = 0;
+  int repetitions = 0;
+  double ns_per_op = 0;
+  double ns_per_op_variance = 0;
+  double ns_per_op_min = 0;
+  double ops_per_second = 0;
+  bool has_counters = false;
+  double cycles_per_op = 0;
+  double instructions_per_op = 0;
+  double cache_misses_per_op = 0;
+  double branch_misses_per_op = 0;
+  bool has_allocations = false;
+  double allocations_per_op = 0;
+  double allocated_bytes_per_op = 0;
+  bool over_budget = false;
+#if defined(BENCHMARK_TRACK_ALLOCATIONS)
+  std::vector<CallSite> call_sites;
+#endif
+};
+
+/**
+ * EN: Discards everything written to std::cout while it is alive, for
+ * examples that print as they work.
+ *
+ * RU: Отбрасывает всё, что пишется в std::cout, пока объект жив, — для
+ * примеров, которые печатают по ходу работы.
+ */
+class MuteOutput {
+ private:
+  class NullBuffer : public std::streambuf {
+   protected:
+    int overflow(int c) override {
+      return c;
+    }
+    std::streamsize xsputn(const char *, std::streamsize count) override {
+      return count;
+    }
+  };
+
+  NullBuffer null_;
+  std::streambuf *previous_;
+
+ public:
+  MuteOutput() : previous_(std::cout.rdbuf(&null_)) {}
+  ~MuteOutput() {
+    std::cout.rdbuf(previous_);
+  }
+};
+
+class Harness {
+ private:
+  bool json_ = false;
+  int repetitions_ = 5;
+  PerfCounters counters_;
+  std::vector<Result> results_;
+  std::map<std::string, double> budgets_;
+
+ public:
+  Harness(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+      if (std::strcmp(argv[i], "--json") == 0) {
+        json_ = true;
+      } else if (std::strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc) {
+        repetitions_ = std::max(1, std::atoi(argv[++i]));
+      }
+    }
+  }
+
+  /**
+   * EN: Sets how many allocations per operation the Run() called `name` may
+   * make. Budgets are checked only when allocations are tracked.
+   *
+   * RU: Задаёт, сколько выделений памяти на операцию может сделать Run() с
+   * именем `name`. Бюджеты проверяются, только когда выделения подсчитываются.
+   */
+  void Budget(const std::string &name, double allocations_per_op) {
+    budgets_[name] = allocations_per_op;
+  }
+
+  /**
+   * EN: Measures `function`, which must perform `operations` operations each
+   * time it is called.
+   *
+   * RU: Измеряет `function`, которая при каждом вызове должна выполнять
+   * `operations` операций.
+   */
+  template <typename Function>
+  const Result &Run(const std::string &name, std::size_t operations,
+                    Function function) {
+    function();
+    std::vector<double> samples;
+    samples.reserve(repetitions_);
+    Counters total;
+    Result result;
+#if defined(BENCHMARK_TRACK_ALLOCATIONS)
+    {
+      AllocationPhase phase(name, operations * repetitions_);
+      Repeat(function, operations, samples, total);
+      result.has_allocations = true;
+      result.allocations_per_op = phase.AllocationsPerOperation();
+      result.allocated_bytes_per_op = phase.BytesPerOperation();
+      result.call_sites = phase.CallSites(3);
+    }
+    std::map<std::string, double>::const_iterator budget = budgets_.find(name);
+    result.over_budget = budget != budgets_.end() &&
+                         result.allocations_per_op > budget->second;
+#else
+    Repeat(function, operations, samples, total);
+#endif
+    result.name = name;
+    result.operations = operations;
+    result.repetitions = repetitions_;
+    result.ns_per_op_min = samples[0];
+    for (double sample : samples) {
+      result.ns_per_op += sample / samples.size();
+      result.ns_per_op_min = std::min(result.ns_per_op_min, sample);
+    }
+    for (double sample : samples) {
+      double deviation = sample - result.ns_per_op;
+      result.ns_per_op_variance += deviation * deviation / samples.size();
+    }
+    result.ops_per_second = 1e9 / result.ns_per_op;
+    result.has_counters = counters_.Available();
+    double total_operations = static_cast<double>(operations) * repetitions_;
+    result.cycles_per_op = total.cycles / total_operations;
+    result.instructions_per_op = total.instructions / total_operations;
+    result.cache_misses_per_op = total.cache_misses / total_operations;
+    result.branch_misses_per_op = total.branch_misses / total_operations;
+    results_.push_back(result);
+
+    if (!json_) {
+      PrintText(result, std::cout);
+    }
+    return results_.back();
+  }
+
+  /**
+   * EN: Prints the JSON document when `--json` was given, and returns the
+   * exit status for main(): 1 if a Run() went over its allocation budget.
+   *
+   * RU: Печатает документ JSON, если был передан `--json`, и возвращает код
+   * завершения для main(): 1, если какой-либо Run() превысил свой бюджет
+   * выделений.
+   */
+  int Finish() const {
+    if (json_) {
+      PrintJson(std::cout);
+    }
+    int status = 0;
+    for (const Result &result : results_) {
+      if (result.over_budget) {
+        std::cerr << result.name << ": " << result.allocations_per_op
+                  << " allocations per op, over the budget of "
+                  << budgets_.find(result.name)->second << "\n";
+        status = 1;
+      }
+    }
+    return status;
+  }
+
+  const std::vector<Result> &Results() const {
+    return results_;
+  }
+
+  void PrintJson(std::ostream &out) const {
+    std::ostringstream json;
+    json << std::setprecision(6) << "{\"benchmarks\":[";
+    for (std::size_t i = 0; i < results_.size(); ++i) {
+      const Result &result = results_[i];
+      json << (i == 0 ? "" : ",") << "\n  {\"name\":\"";
+      WriteEscaped(result.name, json);
+      json << "\",\"operations\":" << result.operations
+           << ",\"repetitions\":" << result.repetitions
+           << ",\"ns_per_op\":" << result.ns_per_op
+           << ",\"ns_per_op_variance\":" << result.ns_per_op_variance
+           << ",\"ns_per_op_min\":" << result.ns_per_op_min
+           << ",\"ops_per_second\":" << result.ops_per_second;
+      if (result.has_counters) {
+        json << ",\"cycles_per_op\":" << result.cycles_per_op
+             << ",\"instructions_per_op\":" << result.instructions_per_op
+             << ",\"cache_misses_per_op\":" << result.cache_misses_per_op
+             << ",\"branch_misses_per_op\":" << result.branch_misses_per_op;
+      } else {
+        json << ",\"cycles_per_op\":null,\"instructions_per_op\":null"
+             << ",\"cache_misses_per_op\":null,\"branch_misses_per_op\":null";
+      }
+      if (result.has_allocations) {
+        json << ",\"allocations_per_op\":" << result.allocations_per_op
+             << ",\"allocated_bytes_per_op\":" << result.allocated_bytes_per_op
+             << ",\"over_budget\":" << (result.over_budget ? "true" : "false");
+      } else {
+        json << ",\"allocations_per_op\":null,\"allocated_bytes_per_op\":null";
+      }
+#if defined(BENCHMARK_TRACK_ALLOCATIONS)
+      json << ",\"call_sites\":[";
+      for (std::size_t j = 0; j < result.call_sites.size(); ++j) {
+        const CallSite &site = result.call_sites[j];
+        json << (j == 0 ? "" : ",") << "{\"allocations\":" << site.allocations
+             << ",\"bytes\":" << site.bytes << ",\"frames\":\"";
+        WriteEscaped(site.frames, json);
+        json << "\"}";
+      }
+      json << "]";
+#endif
+      json << "}";
+    }
+    json << "\n]}\n";
+    out << json.str();
+  }
+
+  static void PrintText(const Result &result, std::ostream &out) {
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(2) << result.name << ": "
+         << result.ns_per_op << " ns/op (+/- "
+         << std::sqrt(result.ns_per_op_variance) << "), "
+         << result.ops_per_second / 1e6 << " M ops/s";
+    if (result.has_counters) {
+      text << ", " << result.cycles_per_op << " cycles, "
+           << result.instructions_per_op << " instructions, "
+           << result.cache_misses_per_op << " cache misses, "
+           << result.branch_misses_per_op << " branch misses per op";
+    }
+    if (result.has_allocations) {
+      text << ", " << result.allocations_per_op << " allocations ("
+           << result.allocated_bytes_per_op << " bytes) per op"
+           << (result.over_budget ? ", OVER BUDGET" : "");
+    }
+    text << "\n";
+#if defined(BENCHMARK_TRACK_ALLOCATIONS)
+    for (const CallSite &site : result.call_sites) {
+      text << "    " << site.allocations << " allocations, " << site.bytes
+           << " bytes: " << site.frames << "\n";
+    }
+#endif
+    out << text.str();
+  }
+
+ private:
+  template <typename Function>
+  void Repeat(Function &function, std::size_t operations,
+              std::vector<double> &samples, Counters &total) {
+    for (int repetition = 0; repetition < repetitions_; ++repetition) {
+      counters_.Start();
+      std::chrono::steady_clock::time_point start =
+          std::chrono::steady_clock::now();
+      function();
+      std::chrono::duration<double, std::nano> elapsed =
+          std::chrono::steady_clock::now() - start;
+      Counters counters = counters_.Stop();
+      samples.push_back(elapsed.count() / operations);
+      total.cycles += counters.cycles;
+      total.instructions += counters.instructions;
+      total.cache_misses += counters.cache_misses;
+      total.branch_misses += counters.branch_misses;
+    }
+  }
+
+  static void WriteEscaped(const std::string &text, std::ostream &out) {
+    for (char c : text) {
+      if (c == '"' || c == '\\') {
+        out << '\\' << c;
+      } else if (static_cast<unsigned char>(c) < 0x20) {
+        out << ' ';
+      } else {
+        out << c;
+      }
+    }
+  }
+};
+
+}  // namespace benchmark
+
+#endif  // BENCHMARK_BENCHMARK_H_
@@ -1,5 +1,18 @@
+#include <atomic>
+#include <cstddef>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
+
+#include "../../Benchmark/benchmark.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 /**
  * EN: Bridge Design Pattern
@@ -40,10 +53,79 @@
  * определяет операции более высокого уровня, основанные на этих примитивах.
  */
 
+/**
+ * EN: A view of one record handed across the bridge in a batch.
+ *
+ * RU: Представление одной записи, передаваемой через мост в пакете.
+ */
+struct Buffer {
+  const char *data;
+  std::size_t size;
+};
+
 class Implementation {
  public:
   virtual ~Implementation() {}
   virtual std::string OperationImplementation() const = 0;
+  /**
+   * EN: The batch entry points take a whole run of operations per call, so a
+   * batch crosses the bridge with a single virtual call, and the results are
+   * written into caller-provided storage instead of fresh strings. By default
+   * they fall back to the single operations; Implementations override them
+   * when they can do better.
+   *
+   * RU: Пакетные точки входа принимают целую серию операций за один вызов, так
+   * что пакет пересекает мост одним виртуальным вызовом, а результаты
+   * записываются в память, предоставленную вызывающим кодом, а не в новые
+   * строки. По умолчанию они сводятся к одиночным операциям; Реализации
+   * переопределяют их, когда могут сделать это лучше.
+   */
+  virtual void OperationsImplementation(std::size_t count,
+                                        std::string &out) const {
+    for (std::size_t i = 0; i < count; ++i) {
+      out += this->OperationImplementation();
+    }
+  }
+  /**
+   * EN: A primitive with a default, portable implementation, which platform
+   * specific Implementations can replace with a faster one.
+   *
+   * RU: Примитив с переносимой реализацией по умолчанию, которую Реализации для
+   * конкретных платформ могут заменить более быстрой.
+   */
+  virtual std::size_t CountImplementation(const char *data, std::size_t size,
+                                          char byte) const {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+      count += data[i] == byte;
+    }
+    return count;
+  }
+  virtual void CountBatchImplementation(const Buffer *buffers,
+                                        std::size_t count, char byte,
+                                        std::size_t *results) const {
+    for (std::size_t i = 0; i < count; ++i) {
+      results[i] =
+          this->CountImplementation(buffers[i].data, buffers[i].size, byte);
+    }
+  }
+
+ protected:
+  /**
+   * EN: The batch operation of an Implementation whose result is a fixed
+   * string: `count` copies of it, appended after a single reservation.
+   *
+   * RU: Пакетная операция Реализации, результат которой — фиксированная
+   * строка: `count` её копий, добавленных после одного резервирования.
+   */
+  template <std::size_t N>
+  static void AppendRepeated(const char (&result)[N], std::size_t count,
+                             std::string &out) {
+    out.reserve(out.size() + count * (N - 1));
+    for (std::size_t i = 0; i < count; ++i) {
+      out.append(result, N - 1);
+    }
+  }
 };
 
 /**
@@ -58,14 +140,240 @@ class ConcreteImplementationA : public Implementation {
   std::string OperationImplementation() const override {
     return "ConcreteImplementationA: Here's the result on the platform A.\n";
   }
+  void OperationsImplementation(std::size_t count,
+                                std::string &out) const override {
+    AppendRepeated(
+        "ConcreteImplementationA: Here's the result on the platform A.\n",
+        count, out);
+  }
 };
 class ConcreteImplementationB : public Implementation {
  public:
   std::string OperationImplementation() const override {
     return "ConcreteImplementationB: Here's the result on the platform B.\n";
   }
+  void OperationsImplementation(std::size_t count,
+                                std::string &out) const override {
+    AppendRepeated(
+        "ConcreteImplementationB: Here's the result on the platform B.\n",
+        count, out);
+  }
+};
+
+/**
+ * EN: A Bridge also lets a single binary pick the best Implementation for the
+ * machine it runs on. Below, the same primitive (counting the occurrences of a
+ * byte in a buffer) is implemented with scalar code and with SSE2, AVX2 and
+ * AVX-512 instructions. The choice is made once, when the Implementation is
+ * created from the detected CPU features; after that, every call costs one
+ * virtual call, exactly like with any other Implementation.
+ *
+ * The vector kernels need GCC or Clang on x86-64. Elsewhere, only the scalar
+ * Implementation is available.
+ *
+ * Each kernel class keeps its kernel in a private, non-virtual Count function
+ * and overrides the batch primitive with a loop over it. The loop is compiled
+ * for the same target as the kernel, which lets the compiler inline the kernel
+ * into it: a function cannot be inlined into a caller built for a smaller
+ * instruction set, so a shared loop would call the kernel out of line for
+ * every record.
+ *
+ * RU: Мост также позволяет одному исполняемому файлу выбрать лучшую Реализацию
+ * для машины, на которой он запущен. Ниже один и тот же примитив (подсчёт
+ * вхождений байта в буфере) реализован скалярным кодом и инструкциями SSE2,
+ * AVX2 и AVX-512. Выбор делается один раз, при создании Реализации по
+ * обнаруженным возможностям процессора; после этого каждый вызов стоит одного
+ * виртуального вызова, точно так же, как с любой другой Реализацией.
+ *
+ * Векторным ядрам нужен GCC или Clang на x86-64. В остальных случаях доступна
+ * только скалярная Реализация.
+ *
+ * Каждый класс ядра хранит своё ядро в закрытой невиртуальной функции Count и
+ * переопределяет пакетный примитив циклом по ней. Цикл компилируется для того
+ * же набора инструкций, что и ядро, что позволяет компилятору встроить в него
+ * ядро: функцию нельзя встроить в вызывающую функцию, собранную для меньшего
+ * набора инструкций, поэтому общий цикл вызывал бы ядро отдельно для каждой
+ * записи.
+ */
+class ScalarImplementation : public Implementation {
+ public:
+  std::string OperationImplementation() const override {
+    return "ScalarImplementation: Here's the result with scalar code.\n";
+  }
+  void OperationsImplementation(std::size_t count,
+                                std::string &out) const override {
+    AppendRepeated(
+        "ScalarImplementation: Here's the result with scalar code.\n",
+        count, out);
+  }
+  void CountBatchImplementation(const Buffer *buffers, std::size_t count,
+                                char byte,
+                                std::size_t *results) const override {
+    for (std::size_t i = 0; i < count; ++i) {
+      results[i] = Implementation::CountImplementation(buffers[i].data,
+                                                       buffers[i].size, byte);
+    }
+  }
+};
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define HAS_X86_KERNELS
+
+class Sse2Implementation : public Implementation {
+ public:
+  std::string OperationImplementation() const override {
+    return "Sse2Implementation: Here's the result with SSE2 instructions.\n";
+  }
+  void OperationsImplementation(std::size_t count,
+                                std::string &out) const override {
+    AppendRepeated(
+        "Sse2Implementation: Here's the result with SSE2 instructions.\n",
+        count, out);
+  }
+  __attribute__((target("sse2,popcnt")))
+  std::size_t CountImplementation(const char *data, std::size_t size,
+                                  char byte) const override {
+    return Count(data, size, byte);
+  }
+  __attribute__((target("sse2,popcnt")))
+  void CountBatchImplementation(const Buffer *buffers, std::size_t count,
+                                char byte,
+                                std::size_t *results) const override {
+    for (std::size_t i = 0; i < count; ++i) {
+      results[i] = Count(buffers[i].data, buffers[i].size, byte);
+    }
+  }
+
+ private:
+  __attribute__((target("sse2,popcnt")))
+  std::size_t Count(const char *data, std::size_t size, char byte) const {
+    const __m128i needle = _mm_set1_epi8(byte);
+    std::size_t count = 0, i = 0;
+    for (; i + 16 <= size; i += 16) {
+      __m128i block =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+      count += _mm_popcnt_u32(_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle)));
+    }
+    return count +
+           Implementation::CountImplementation(data + i, size - i, byte);
+  }
+};
+
+class Avx2Implementation : public Implementation {
+ public:
+  std::string OperationImplementation() const override {
+    return "Avx2Implementation: Here's the result with AVX2 instructions.\n";
+  }
+  void OperationsImplementation(std::size_t count,
+                                std::string &out) const override {
+    AppendRepeated(
+        "Avx2Implementation: Here's the result with AVX2 instructions.\n",
+        count, out);
+  }
+  __attribute__((target("avx2,popcnt")))
+  std::size_t CountImplementation(const char *data, std::size_t size,
+                                  char byte) const override {
+    return Count(data, size, byte);
+  }
+  __attribute__((target("avx2,popcnt")))
+  void CountBatchImplementation(const Buffer *buffers, std::size_t count,
+                                char byte,
+                                std::size_t *results) const override {
+    for (std::size_t i = 0; i < count; ++i) {
+      results[i] = Count(buffers[i].data, buffers[i].size, byte);
+    }
+  }
+
+ private:
+  __attribute__((target("avx2,popcnt")))
+  std::size_t Count(const char *data, std::size_t size, char byte) const {
+    const __m256i needle = _mm256_set1_epi8(byte);
+    std::size_t count = 0, i = 0;
+    for (; i + 32 <= size; i += 32) {
+      __m256i block =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+      count += _mm_popcnt_u32(static_cast<unsigned>(
+          _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle))));
+    }
+    return count +
+           Implementation::CountImplementation(data + i, size - i, byte);
+  }
 };
 
+class Avx512Implementation : public Implementation {
+ public:
+  std::string OperationImplementation() const override {
+    return "Avx512Implementation: Here's the result with AVX-512 "
+           "instructions.\n";
+  }
+  void OperationsImplementation(std::size_t count,
+                                std::string &out) const override {
+    AppendRepeated(
+        "Avx512Implementation: Here's the result with AVX-512 instructions.\n",
+        count, out);
+  }
+  __attribute__((target("avx512f,avx512bw,popcnt")))
+  std::size_t CountImplementation(const char *data, std::size_t size,
+                                  char byte) const override {
+    return Count(data, size, byte);
+  }
+  __attribute__((target("avx512f,avx512bw,popcnt")))
+  void CountBatchImplementation(const Buffer *buffers, std::size_t count,
+                                char byte,
+                                std::size_t *results) const override {
+    for (std::size_t i = 0; i < count; ++i) {
+      results[i] = Count(buffers[i].data, buffers[i].size, byte);
+    }
+  }
+
+ private:
+  __attribute__((target("avx512f,avx512bw,popcnt")))
+  std::size_t Count(const char *data, std::size_t size, char byte) const {
+    const __m512i needle = _mm512_set1_epi8(byte);
+    std::size_t count = 0, i = 0;
+    for (; i + 64 <= size; i += 64) {
+      __m512i block = _mm512_loadu_si512(data + i);
+      count += _mm_popcnt_u64(_mm512_cmpeq_epi8_mask(block, needle));
+    }
+    // EN: A masked load never touches the bytes left out of the mask, so the
+    // tail, and with it a whole short record, takes one more vector step.
+    //
+    // RU: Загрузка с маской никогда не обращается к байтам вне маски, поэтому
+    // хвост, а вместе с ним и целая короткая запись, обрабатывается ещё одним
+    // векторным шагом.
+    if (i < size) {
+      __mmask64 mask = ~0ULL >> (64 - (size - i));
+      __m512i block = _mm512_maskz_loadu_epi8(mask, data + i);
+      count += _mm_popcnt_u64(_mm512_mask_cmpeq_epi8_mask(mask, block, needle));
+    }
+    return count;
+  }
+};
+#endif
+
+/**
+ * EN: Detects the CPU features once and creates the best Implementation the
+ * machine supports. The caller owns the result.
+ *
+ * RU: Один раз определяет возможности процессора и создаёт лучшую Реализацию,
+ * которую поддерживает машина. Результатом владеет вызывающий код.
+ */
+Implementation *CreateImplementationForThisCpu() {
+#ifdef HAS_X86_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+    return new Avx512Implementation;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+    return new Avx2Implementation;
+  }
+  if (__builtin_cpu_supports("sse2") && __builtin_cpu_supports("popcnt")) {
+    return new Sse2Implementation;
+  }
+#endif
+  return new ScalarImplementation;
+}
+
 /**
  * EN: The Abstraction defines the interface for the "control" part of the two
  * class hierarchies. It maintains a reference to an object of the
@@ -94,6 +402,27 @@ class Abstraction {
     return "Abstraction: Base operation with:\n" +
            this->implementation_->OperationImplementation();
   }
+
+  virtual std::size_t Count(const char *data, std::size_t size,
+                            char byte) const {
+    return this->implementation_->CountImplementation(data, size, byte);
+  }
+
+  /**
+   * EN: The batch operations cross the bridge once per batch.
+   *
+   * RU: Пакетные операции пересекают мост один раз на пакет.
+   */
+  virtual void Count(const Buffer *buffers, std::size_t count, char byte,
+                     std::size_t *results) const {
+    this->implementation_->CountBatchImplementation(buffers, count, byte,
+                                                    results);
+  }
+
+  virtual void Operations(std::size_t count, std::string &out) const {
+    out += "Abstraction: Base operations with:\n";
+    this->implementation_->OperationsImplementation(count, out);
+  }
 };
 /**
  * EN: You can extend the Abstraction without changing the Implementation
@@ -109,6 +438,163 @@ class ExtendedAbstraction : public Abstraction {
     return "ExtendedAbstraction: Extended operation with:\n" +
            this->implementation_->OperationImplementation();
   }
+  void Operations(std::size_t count, std::string &out) const override {
+    out += "ExtendedAbstraction: Extended operations with:\n";
+    this->implementation_->OperationsImplementation(count, out);
+  }
+};
+
+/**
+ * EN: An Abstraction whose Implementation can be replaced while other threads
+ * keep calling it, e.g. to move from one backend to another under load.
+ *
+ * Calls never take a lock. A call registers itself in a reader counter of the
+ * current epoch, loads the current Implementation and unregisters when done.
+ * Swap publishes the new Implementation with a single atomic exchange, so every
+ * call started afterwards uses it right away. Before handing the old
+ * Implementation back to the caller, Swap waits until each reader counter has
+ * been seen at zero, i.e. until every call that might still be using the old
+ * Implementation has finished. Flipping the epoch before each wait sends new
+ * calls to the other epoch's counters, so the ones being waited on can drain.
+ *
+ * Every call writes to its counter twice, so the counters must not make
+ * threads fight over cache lines: each epoch has several counters, threads
+ * are spread over them, and every counter has a cache line of its own, away
+ * from the epoch and the Implementation pointer that all calls read.
+ *
+ * It is still an Abstraction, so client code takes it like any other. The
+ * plain Implementation pointer of the base stays null: every operation is
+ * overridden to go through the atomic one.
+ *
+ * RU: Абстракция, Реализацию которой можно заменить, пока другие потоки
+ * продолжают её вызывать, например, чтобы перейти с одного бэкенда на другой
+ * под нагрузкой.
+ *
+ * Вызовы никогда не берут блокировку. Вызов регистрируется в счётчике читателей
+ * текущей эпохи, загружает текущую Реализацию и снимает регистрацию по
+ * завершении. Swap публикует новую Реализацию одним атомарным обменом, так что
+ * каждый вызов, начатый после этого, сразу использует её. Прежде чем вернуть
+ * старую Реализацию вызывающему коду, Swap ждёт, пока каждый счётчик читателей
+ * не будет замечен на нуле, то есть пока не завершится каждый вызов, который
+ * ещё мог использовать старую Реализацию. Смена эпохи перед каждым ожиданием
+ * направляет новые вызовы к счётчикам другой эпохи, так что те, которых ждут,
+ * могут опустеть.
+ *
+ * Каждый вызов дважды пишет в свой счётчик, поэтому счётчики не должны
+ * заставлять потоки бороться за строки кэша: у каждой эпохи несколько
+ * счётчиков, потоки распределяются по ним, и у каждого счётчика своя строка
+ * кэша, отдельно от эпохи и указателя на Реализацию, которые читают все вызовы.
+ *
+ * Это по-прежнему Абстракция, так что клиентский код принимает её как любую
+ * другую. Простой указатель на Реализацию в базовом классе остаётся нулевым:
+ * каждая операция переопределена так, чтобы идти через атомарный.
+ */
+class SwappableAbstraction : public Abstraction {
+ public:
+  explicit SwappableAbstraction(std::unique_ptr<Implementation> implementation)
+      : Abstraction(nullptr), current_(implementation.release()) {
+  }
+
+  ~SwappableAbstraction() {
+    delete current_.load();
+  }
+
+  std::string Operation() const override {
+    Reader reader(*this);
+    return "SwappableAbstraction: Operation with:\n" +
+           reader->OperationImplementation();
+  }
+
+  std::size_t Count(const char *data, std::size_t size,
+                    char byte) const override {
+    Reader reader(*this);
+    return reader->CountImplementation(data, size, byte);
+  }
+
+  void Count(const Buffer *buffers, std::size_t count, char byte,
+             std::size_t *results) const override {
+    Reader reader(*this);
+    reader->CountBatchImplementation(buffers, count, byte, results);
+  }
+
+  void Operations(std::size_t count, std::string &out) const override {
+    Reader reader(*this);
+    out += "SwappableAbstraction: Operations with:\n";
+    reader->OperationsImplementation(count, out);
+  }
+
+  /**
+   * EN: Publishes `implementation` and returns the previous one once no call
+   * can be using it any more. Callers of the operations never wait; Swap
+   * itself blocks until the calls that started before it have drained, and
+   * concurrent swaps take turns.
+   *
+   * RU: Публикует `implementation` и возвращает предыдущую Реализацию, как
+   * только ни один вызов больше не может её использовать. Вызывающие операции
+   * никогда не ждут; сам Swap блокируется, пока не завершатся вызовы, начатые
+   * до него, а одновременные замены выполняются по очереди.
+   */
+  std::unique_ptr<Implementation> Swap(
+      std::unique_ptr<Implementation> implementation) {
+    std::lock_guard<std::mutex> lock(swap_mutex_);
+    std::unique_ptr<Implementation> previous(
+        current_.exchange(implementation.release()));
+    for (int phase = 0; phase < 2; ++phase) {
+      unsigned epoch = epoch_.fetch_add(1);
+      for (Counter &counter : readers_[epoch & 1]) {
+        while (counter.value.load() != 0) {
+          std::this_thread::yield();
+        }
+      }
+    }
+    return previous;
+  }
+
+ private:
+  static const std::size_t kStripes = 8;
+
+  // EN: 64 bytes is the cache line size of current x86-64 and most ARM cores.
+  //
+  // RU: 64 байта — размер строки кэша современных процессоров x86-64 и
+  // большинства ядер ARM.
+  struct alignas(64) Counter {
+    std::atomic<std::size_t> value{0};
+  };
+
+  // EN: Threads take the stripes in turn, the first time they make a call.
+  //
+  // RU: Потоки занимают полосы по очереди, при своём первом вызове.
+  static std::size_t Stripe() {
+    static std::atomic<std::size_t> next{0};
+    thread_local std::size_t stripe = next.fetch_add(1) % kStripes;
+    return stripe;
+  }
+
+  class Reader {
+   public:
+    explicit Reader(const SwappableAbstraction &abstraction)
+        : counter_(
+              abstraction.readers_[abstraction.epoch_.load() & 1][Stripe()]
+                  .value) {
+      counter_.fetch_add(1);
+      implementation_ = abstraction.current_.load();
+    }
+    ~Reader() {
+      counter_.fetch_sub(1);
+    }
+    const Implementation *operator->() const {
+      return implementation_;
+    }
+
+   private:
+    std::atomic<std::size_t> &counter_;
+    const Implementation *implementation_;
+  };
+
+  std::atomic<Implementation *> current_;
+  mutable std::atomic<unsigned> epoch_{0};
+  mutable Counter readers_[2][kStripes];
+  std::mutex swap_mutex_;
 };
 
 /**
@@ -135,7 +621,107 @@ void ClientCode(const Abstraction& abstraction) {
  * комбинацией абстракции и реализации.
  */
 
-int main() {
+/**
+ * EN: Run with `--benchmark` to see that choosing the Implementation is a
+ * one-off cost, and that afterwards a call costs the same as with a fixed
+ * Implementation.
+ *
+ * RU: Запустите с `--benchmark`, чтобы увидеть, что выбор Реализации — разовая
+ * затрата, и что после него вызов стоит столько же, сколько с заранее заданной
+ * Реализацией.
+ */
+void Benchmark(benchmark::Harness &harness) {
+  std::vector<char> buffer(4096, 'b');
+  for (std::size_t i = 0; i < buffer.size(); i += 3) {
+    buffer[i] = 'a';
+  }
+  const int calls = 1000000;
+
+  const int selections = 1000;
+  harness.Run("select the Implementation", selections, [&] {
+    for (int i = 0; i < selections; ++i) {
+      Implementation *implementation = CreateImplementationForThisCpu();
+      benchmark::DoNotOptimize(implementation);
+      delete implementation;
+    }
+  });
+  Implementation *best = CreateImplementationForThisCpu();
+  // EN: Kept off stdout, which may be carrying the JSON report.
+  //
+  // RU: Не выводится в stdout, где может находиться отчёт в формате JSON.
+  std::cerr << "Selected " << best->OperationImplementation();
+
+  Implementation *scalar = new ScalarImplementation;
+  Implementation *implementations[] = {scalar, best};
+  for (Implementation *implementation : implementations) {
+    Abstraction abstraction(implementation);
+    const char *name =
+        implementation == scalar ? "scalar, 4 KiB" : "selected, 4 KiB";
+    harness.Run(name, calls, [&] {
+      for (int i = 0; i < calls; ++i) {
+        benchmark::DoNotOptimize(
+            abstraction.Count(buffer.data(), buffer.size(), 'a'));
+      }
+    });
+  }
+
+  // EN: For short records the call itself dominates, which is what batches
+  // are for.
+  //
+  // RU: Для коротких записей основное время занимает сам вызов, и именно для
+  // этого нужны пакеты.
+  const std::size_t records = 1024, record_size = 48;
+  std::vector<Buffer> batch;
+  for (std::size_t i = 0; i < records; ++i) {
+    batch.push_back(Buffer{buffer.data() + i % (buffer.size() - record_size),
+                           record_size});
+  }
+  std::vector<std::size_t> results(records);
+  Abstraction abstraction(best);
+  const int rounds = calls / static_cast<int>(records);
+  harness.Run("selected, 48-byte records one by one", rounds * records, [&] {
+    for (int round = 0; round < rounds; ++round) {
+      for (std::size_t i = 0; i < records; ++i) {
+        results[i] = abstraction.Count(batch[i].data, batch[i].size, 'a');
+      }
+      benchmark::DoNotOptimize(results);
+    }
+  });
+  // EN: The default batch loop of the Implementation interface is built for the
+  // baseline target, so it makes a call per record instead of inlining the
+  // kernel like the kernel's own loop does.
+  //
+  // RU: Цикл пакета по умолчанию из интерфейса Реализации собран для базового
+  // набора инструкций, поэтому он делает вызов на каждую запись, а не
+  // встраивает ядро, как это делает собственный цикл ядра.
+  harness.Run(
+      "selected, 48-byte records in batches of 1024, default loop",
+      rounds * records, [&] {
+        for (int round = 0; round < rounds; ++round) {
+          best->Implementation::CountBatchImplementation(
+              batch.data(), batch.size(), 'a', results.data());
+          benchmark::DoNotOptimize(results);
+        }
+      });
+  harness.Run(
+      "selected, 48-byte records in batches of 1024", rounds * records, [&] {
+        for (int round = 0; round < rounds; ++round) {
+          abstraction.Count(batch.data(), batch.size(), 'a', results.data());
+          benchmark::DoNotOptimize(results);
+        }
+      });
+
+  delete scalar;
+  delete best;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1 && std::strcmp(argv[1], "--benchmark") == 0) {
+    benchmark::Harness harness(argc, argv);
+    Benchmark(harness);
+    return harness.Finish();
+  }
+
   Implementation* implementation = new ConcreteImplementationA;
   Abstraction* abstraction = new Abstraction(implementation);
   ClientCode(*abstraction);
@@ -146,9 +732,57 @@ int main() {
   implementation = new ConcreteImplementationB;
   abstraction = new ExtendedAbstraction(implementation);
   ClientCode(*abstraction);
+  std::cout << std::endl;
 
   delete implementation;
   delete abstraction;
 
+  implementation = CreateImplementationForThisCpu();
+  abstraction = new Abstraction(implementation);
+  const char text[] = "a bridge picks a kernel at startup";
+  std::cout << "Abstraction: Counted "
+            << abstraction->Count(text, sizeof(text) - 1, 'a')
+            << " 'a' bytes with the Implementation selected for this CPU.\n";
+  Buffer words[] = {{text, 8}, {text + 9, 5}, {text + 15, 6}};
+  std::size_t counts[3];
+  abstraction->Count(words, 3, 'a', counts);
+  std::cout << "Abstraction: Counted " << counts[0] << ", " << counts[1]
+            << " and " << counts[2]
+            << " 'a' bytes in a batch of 3 records with a single call.\n";
+  std::cout << std::endl;
+
+  delete implementation;
+  delete abstraction;
+
+  implementation = new ConcreteImplementationA;
+  abstraction = new Abstraction(implementation);
+  std::string out;
+  abstraction->Operations(2, out);
+  std::cout << out;
+  std::cout << std::endl;
+
+  delete implementation;
+  delete abstraction;
+
+  SwappableAbstraction swappable(
+      std::unique_ptr<Implementation>(new ConcreteImplementationA));
+  ClientCode(swappable);
+  std::atomic<bool> running(true);
+  std::thread caller([&swappable, &running]() {
+    while (running.load()) {
+      swappable.Operation();
+    }
+  });
+  std::unique_ptr<Implementation> previous = swappable.Swap(
+      std::unique_ptr<Implementation>(new ConcreteImplementationB));
+  // EN: No call can be using `previous` at this point, so it may be deleted.
+  //
+  // RU: В этот момент ни один вызов не может использовать `previous`, поэтому
+  // её можно удалить.
+  previous.reset();
+  ClientCode(swappable);
+  running = false;
+  caller.join();
+
   return 0;
 }
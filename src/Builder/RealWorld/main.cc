@@ -1,7 +1,25 @@
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
 #include <iostream>
+#include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
+
 /**
  * EN: Real World Example for the Builder Design Pattern (C++03/11 Evolution)
  *
@@ -30,13 +48,20 @@
  * same technique. However, this approach is for only demonstration purposes in
  * order to show the subtle difference in the C++03- and C++11-subvariants of
  * the Fluent Builder as part of the evolution of the design pattern itself.
+ *
+ * With C++11 move semantics available, content strings are taken by value and
+ * moved into place, and a builder used as a temporary hands its tree over
+ * instead of copying it, and subtrees can be rendered on several threads.
  */
 #if (defined(_MSVC_LANG) && _MSVC_LANG >= 201103L) || \
     ((!defined(_MSVC_LANG)) && __cplusplus >= 201103L)
 
-#define append_element(tag, content) emplace_back(tag, content)
+#define append_element(tag, content) emplace_back(tag, std::move(content))
 #define ranged_for(children) for (auto const &child : children)
 
+#define HAS_MOVE_SEMANTICS
+#define HAS_STD_THREAD
+
 #define ENUMMERATION_TYPE() enum class
 #define TAG_SCOPE() html::Tag
 
@@ -53,6 +78,17 @@
 
 #endif
 
+#ifdef HAS_STD_THREAD
+#include <future>
+#include <thread>
+#endif
+
+#ifdef HAS_MOVE_SEMANTICS
+#include <fcntl.h>
+
+#include "../../Benchmark/benchmark.h"
+#endif
+
 /**
  * EN: The html namespace contains the core machinery of the Fluent Builder
  * Pattern, namely, the Element and ElementBuilder classes. To showcase the
@@ -67,6 +103,8 @@ namespace html {
  * a friend class of the Element class in this Fluent Builder implementation.
  */
 class ElementBuilder;
+class HtmlWriter;
+class RenderCache;
 
 /**
  * EN: Enumeration to represent different HTML elements. (Note that in C++11
@@ -91,6 +129,78 @@ std::string to_string(Tag tag) {
   }
 }
 
+/**
+ * EN: The same names as ready-made markup. The streaming writer below copies
+ * these literals straight into its buffer instead of building a new string
+ * for every opening and closing tag.
+ */
+struct TagLiteral {
+  char const *open;
+  std::size_t open_size;
+  char const *close;
+  std::size_t close_size;
+};
+
+#define TAG_LITERAL(name) \
+  { "<" name ">", sizeof("<" name ">") - 1, "</" name ">\n", sizeof("</" name ">\n") - 1 }
+
+TagLiteral const &tag_literal(Tag tag) {
+  static TagLiteral const literals[] = {TAG_LITERAL("body"), TAG_LITERAL("h1"),
+                                        TAG_LITERAL("h2"), TAG_LITERAL("p"),
+                                        /* ... */ TAG_LITERAL("tag")};
+  static std::size_t const count = sizeof(literals) / sizeof(literals[0]);
+  std::size_t index = static_cast<std::size_t>(tag);
+  return literals[index < count - 1 ? index : count - 1];
+}
+
+#undef TAG_LITERAL
+
+/**
+ * EN: Every Element carries two independent hashes of its whole subtree: the
+ * tag, the content and the hashes of the children in order. It also carries
+ * the size of its markup before escaping. A leaf gets these values when it is
+ * constructed, and the builder folds each new child into those of the root,
+ * so they are always up to date without walking the tree again.
+ */
+inline uint64_t hash_node(Tag tag, std::string const &content) {
+  uint64_t hash = 14695981039346656037ULL;  // FNV-1a
+  hash = (hash ^ static_cast<uint64_t>(tag)) * 1099511628211ULL;
+  for (std::size_t i = 0; i < content.size(); ++i) {
+    hash = (hash ^ static_cast<unsigned char>(content[i])) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+inline uint64_t hash_child(uint64_t hash, uint64_t subtree) {
+  return hash ^ (subtree + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2));
+}
+
+// EN: The finaliser of SplitMix64, which spreads every input bit over the
+// whole result.
+inline uint64_t mix(uint64_t x) {
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+inline uint64_t check_node(Tag tag, std::string const &content) {
+  uint64_t check = mix(static_cast<uint64_t>(tag) + content.size());
+  for (std::size_t i = 0; i < content.size(); ++i) {
+    check = (check ^ static_cast<unsigned char>(content[i])) *
+            0x9e3779b97f4a7c15ULL;
+  }
+  return mix(check);
+}
+
+inline uint64_t check_child(uint64_t check, uint64_t subtree) {
+  return mix(check ^ (subtree * 0xff51afd7ed558ccdULL));
+}
+
+inline std::size_t node_size(Tag tag, std::string const &content) {
+  TagLiteral const &literal = tag_literal(tag);
+  return literal.open_size + content.size() + 1 + literal.close_size;
+}
+
 /**
  * EN: This client-facing Element class is essentially a tree node that
  * stores its children by value in a dynamic container. The Fluent Builder
@@ -99,8 +209,18 @@ std::string to_string(Tag tag) {
  */
 class Element {
  public:
+#ifdef HAS_MOVE_SEMANTICS
+  Element(Tag tag, std::string content = std::string())
+      : tag_(tag), content_(std::move(content)),
+        hash_(hash_node(tag_, content_)), check_(check_node(tag_, content_)),
+        size_(node_size(tag_, content_)) {}
+#else
   Element(Tag tag, std::string const &content = std::string())
-      : tag_(tag), content_(content) {}
+      : tag_(tag), content_(content), hash_(hash_node(tag_, content_)),
+        check_(check_node(tag_, content_)), size_(node_size(tag_, content_)) {}
+#endif
+
+  uint64_t hash() const { return hash_; }
 
   /**
    * EN: The print method generates markup. Note that the ranged-based for
@@ -121,10 +241,14 @@ class Element {
 
  private:
   friend class ElementBuilder;
+  friend class HtmlWriter;
 
  private:
   Tag tag_;
   std::string content_;
+  uint64_t hash_;
+  uint64_t check_;
+  std::size_t size_;
   std::vector<Element> children_;
 };
 
@@ -137,27 +261,669 @@ class Element {
  * differs between the C++03 and C++11 standards; in the former case, the
  * Element constructor must be called explicitly whereas in the latter case, the
  * arguments are forwarded to the Element constructor.
+ *
+ * In C++11 the builder is also aware of its value category. When it is used as
+ * a temporary, add_child() keeps returning an rvalue so that the final
+ * conversion (or an explicit build()) moves the whole tree out of the builder
+ * rather than copying every child and string. A named builder still copies,
+ * so it can go on building.
+ *
+ * A child is either a new leaf, from a tag and its content, or a whole Element
+ * built beforehand, typically by a nested builder, so trees can be as deep as
+ * needed.
  */
 class ElementBuilder {
  public:
+#ifdef HAS_MOVE_SEMANTICS
+  explicit ElementBuilder(Tag tag, std::string content = std::string())
+      : root_(Element(tag, std::move(content))) {}
+
+  ElementBuilder &add_child(Tag tag, std::string content = std::string()) & {
+    root_.children_.append_element(tag, content);
+    adopt_last_child();
+    return *this;
+  }
+
+  ElementBuilder &&add_child(Tag tag, std::string content = std::string()) && {
+    root_.children_.append_element(tag, content);
+    adopt_last_child();
+    return std::move(*this);
+  }
+
+  ElementBuilder &add_child(Element subtree) & {
+    root_.children_.push_back(std::move(subtree));
+    adopt_last_child();
+    return *this;
+  }
+
+  ElementBuilder &&add_child(Element subtree) && {
+    root_.children_.push_back(std::move(subtree));
+    adopt_last_child();
+    return std::move(*this);
+  }
+
+  Element build() && { return std::move(root_); }
+
+  operator Element() const & { return root_; }
+  operator Element() && { return std::move(root_); }
+#else
   explicit ElementBuilder(Tag tag, std::string const &content = std::string())
       : root_(Element(tag, content)) {}
 
   ElementBuilder &add_child(Tag tag,
                             std::string const &content = std::string()) {
     root_.children_.append_element(tag, content);
+    adopt_last_child();
+    return *this;
+  }
+
+  ElementBuilder &add_child(Element const &subtree) {
+    root_.children_.push_back(subtree);
+    adopt_last_child();
     return *this;
   }
 
   operator Element() const { return root_; }
+#endif
 
  private:
+  void adopt_last_child() {
+    Element const &last = root_.children_.back();
+    root_.hash_ = hash_child(root_.hash_, last.hash_);
+    root_.check_ = check_child(root_.check_, last.check_);
+    root_.size_ += last.size_;
+  }
+
   Element root_;
 };
 
+/**
+ * EN: The Element tree above gives every node its own vector of children and
+ * its own string, so a large page costs a heap allocation or two per element
+ * and as many deallocations when it goes away. The Document below is an
+ * alternative representation of the same markup: all nodes live in a single
+ * arena (a vector) and refer to each other by index, while all text content is
+ * appended to one shared buffer. Building a page then only grows two buffers,
+ * which can be reserved up front, and destroying it releases just those two.
+ */
+class Document {
+ public:
+  typedef std::size_t NodeId;
+  static const NodeId npos = static_cast<NodeId>(-1);
+
+  Document() : last_root_(npos) {}
+
+  void reserve(std::size_t nodes, std::size_t text_bytes) {
+    nodes_.reserve(nodes);
+    text_.reserve(text_bytes);
+  }
+
+  /**
+   * EN: Appends a node as the last child of `parent`, or as the last top-level
+   * node when `parent` is npos, and returns its index.
+   */
+  NodeId add_node(Tag tag, char const *content, std::size_t length,
+                  NodeId parent) {
+    Node node;
+    node.tag = tag;
+    node.text_begin = text_.size();
+    node.text_size = length;
+    node.first_child = npos;
+    node.last_child = npos;
+    node.next_sibling = npos;
+    text_.append(content, length);
+
+    NodeId id = nodes_.size();
+    nodes_.push_back(node);
+    NodeId &previous = parent == npos ? last_root_ : nodes_[parent].last_child;
+    if (previous != npos) {
+      nodes_[previous].next_sibling = id;
+    } else if (parent != npos) {
+      nodes_[parent].first_child = id;
+    }
+    previous = id;
+    return id;
+  }
+
+  /**
+   * EN: The markup is identical to the one printed for an Element tree.
+   */
+  friend std::ostream &operator<<(std::ostream &os, Document const &d) {
+    for (NodeId id = d.nodes_.empty() ? npos : 0; id != npos;
+         id = d.nodes_[id].next_sibling) {
+      d.print(os, id);
+    }
+    return os;
+  }
+
+ private:
+  struct Node {
+    Tag tag;
+    std::size_t text_begin;
+    std::size_t text_size;
+    NodeId first_child;
+    NodeId last_child;
+    NodeId next_sibling;
+  };
+
+  void print(std::ostream &os, NodeId id) const {
+    Node const &node = nodes_[id];
+    os << "<" << to_string(node.tag) << ">";
+    if (node.text_size != 0) {
+      os.write(text_.data() + node.text_begin, node.text_size);
+    } else {
+      os << "\n";
+    }
+    for (NodeId c = node.first_child; c != npos; c = nodes_[c].next_sibling) {
+      print(os, c);
+    }
+    os << "</" << to_string(node.tag) << ">\n";
+  }
+
+  std::vector<Node> nodes_;
+  std::string text_;
+  NodeId last_root_;
+};
+
+/**
+ * EN: The same Fluent Builder interface, but building into a Document. String
+ * literals are copied straight into the document's text buffer, so no
+ * temporary std::string is created per node either.
+ */
+class DocumentBuilder {
+ public:
+  DocumentBuilder(Document &document, Tag tag, char const *content = "")
+      : document_(document),
+        root_(document.add_node(tag, content, std::strlen(content),
+                                Document::npos)) {}
+
+  DocumentBuilder &add_child(Tag tag, char const *content = "") {
+    document_.add_node(tag, content, std::strlen(content), root_);
+    return *this;
+  }
+
+  DocumentBuilder &add_child(Tag tag, std::string const &content) {
+    document_.add_node(tag, content.data(), content.size(), root_);
+    return *this;
+  }
+
+ private:
+  Document &document_;
+  Document::NodeId root_;
+};
+
+/**
+ * EN: Content has to be escaped before it can be written as markup, but most
+ * content contains nothing to escape. find_special() therefore only looks for
+ * the next of the five special characters, so that the clean run before it
+ * can be copied in one go. On x86 with GCC or Clang the search compares 16
+ * (SSE2) or 32 (AVX2) bytes at a time, picking the widest kernel the CPU
+ * supports on first use; everywhere else it falls back to a plain loop.
+ */
+inline bool is_special(char c) {
+  return c == '<' || c == '>' || c == '&' || c == '"' || c == '\'';
+}
+
+inline std::size_t find_special_scalar(char const *data, std::size_t size) {
+  std::size_t i = 0;
+  while (i < size && !is_special(data[i])) ++i;
+  return i;
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAS_SIMD_ESCAPE
+
+__attribute__((target("sse2"))) inline std::size_t find_special_sse2(
+    char const *data, std::size_t size) {
+  __m128i const lt = _mm_set1_epi8('<'), gt = _mm_set1_epi8('>'),
+                amp = _mm_set1_epi8('&'), quot = _mm_set1_epi8('"'),
+                apos = _mm_set1_epi8('\'');
+  std::size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(data + i));
+    __m128i hit = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, lt), _mm_cmpeq_epi8(v, gt)),
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, amp),
+                                  _mm_cmpeq_epi8(v, quot)),
+                     _mm_cmpeq_epi8(v, apos)));
+    int mask = _mm_movemask_epi8(hit);
+    if (mask != 0) return i + __builtin_ctz(mask);
+  }
+  return i + find_special_scalar(data + i, size - i);
+}
+
+__attribute__((target("avx2"))) inline std::size_t find_special_avx2(
+    char const *data, std::size_t size) {
+  __m256i const lt = _mm256_set1_epi8('<'), gt = _mm256_set1_epi8('>'),
+                amp = _mm256_set1_epi8('&'), quot = _mm256_set1_epi8('"'),
+                apos = _mm256_set1_epi8('\'');
+  std::size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const *>(data + i));
+    __m256i hit = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, lt), _mm256_cmpeq_epi8(v, gt)),
+        _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, amp),
+                                        _mm256_cmpeq_epi8(v, quot)),
+                        _mm256_cmpeq_epi8(v, apos)));
+    unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hit));
+    if (mask != 0) return i + __builtin_ctz(mask);
+  }
+  return i + find_special_sse2(data + i, size - i);
+}
+#endif
+
+typedef std::size_t (*FindSpecial)(char const *, std::size_t);
+
+inline FindSpecial select_find_special() {
+#ifdef HAS_SIMD_ESCAPE
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return find_special_avx2;
+  if (__builtin_cpu_supports("sse2")) return find_special_sse2;
+#endif
+  return find_special_scalar;
+}
+
+inline std::size_t find_special(char const *data, std::size_t size) {
+  static FindSpecial const kernel = select_find_special();
+  return kernel(data, size);
+}
+
+/**
+ * EN: Keeps the rendered markup of subtrees between renders, keyed by their
+ * hash. When a page is rebuilt on every data tick and only a few elements
+ * change, every unchanged subtree hashes to the same value as before and its
+ * bytes are reused; only the subtrees on the path to a change are rendered
+ * again. The root is always rendered, as it changes with any element.
+ * Subtrees smaller than `min_size` bytes are cheaper to render than to look
+ * up and are not kept. Entries that were not used by a render are dropped at
+ * its end, so the cache does not outgrow one document.
+ *
+ * The hash only finds a candidate. An entry is reused only if the second
+ * hash of the subtree matches as well, together with the element's own tag,
+ * content and number of children; comparing the whole subtree would cost as
+ * much as rendering it. Both hashes are fast rather than cryptographic, so
+ * this rules out accidental collisions, not ones crafted on purpose.
+ */
+class RenderCache {
+ public:
+  explicit RenderCache(std::size_t min_size = 256)
+      : min_size_(min_size), generation_(0) {}
+
+  std::size_t size() const { return entries_.size(); }
+
+ private:
+  friend class HtmlWriter;
+
+  struct Entry {
+    Tag tag;
+    std::string content;
+    std::size_t children;
+    uint64_t check;
+    unsigned generation;
+    std::string markup;
+  };
+  typedef std::map<uint64_t, Entry> Entries;
+
+  Entry *find(uint64_t hash) {
+    Entries::iterator it = entries_.find(hash);
+    if (it == entries_.end()) return 0;
+    it->second.generation = generation_;
+    return &it->second;
+  }
+
+  Entry &store(uint64_t hash) {
+    Entry &entry = entries_[hash];
+    entry.generation = generation_;
+    return entry;
+  }
+
+  // EN: Drops the entries that the render just finished did not use.
+  void end_generation() {
+    for (Entries::iterator it = entries_.begin(); it != entries_.end();) {
+      if (it->second.generation != generation_) {
+        entries_.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+    ++generation_;
+  }
+
+  std::size_t min_size_;
+  unsigned generation_;
+  Entries entries_;
+};
+
+/**
+ * EN: A streaming alternative to printing an Element through std::ostream.
+ * The writer walks the tree with an explicit stack instead of recursion,
+ * appends tag literals and content to one reusable byte buffer, and hands the
+ * buffer to a file descriptor whenever it fills up. Both the buffer and the
+ * stack are kept between calls, so rendering many pages with one writer does
+ * not allocate once they have grown to size.
+ *
+ * Unlike the print method, the writer escapes content, so it is safe to build
+ * elements from user text.
+ *
+ * The first failed write is remembered and nothing is written after it;
+ * flush() reports whether all went well.
+ */
+class HtmlWriter {
+ public:
+  explicit HtmlWriter(int fd, std::size_t capacity = 1 << 16)
+      : fd_(fd), buffer_(capacity), size_(0), error_(0) {}
+
+  ~HtmlWriter() { flush(); }
+
+  HtmlWriter &write(Element const &root) {
+    render(root, *this, stack_);
+    return *this;
+  }
+
+  /**
+   * EN: Renders the tree reusing the markup of unchanged subtrees from the
+   * previous render with the same cache.
+   */
+  HtmlWriter &write(Element const &root, RenderCache &cache) {
+    render_children(root, cache, *this);
+    cache.end_generation();
+    return *this;
+  }
+
+#ifdef HAS_STD_THREAD
+  /**
+   * EN: The children of the root are independent subtrees, so they can be
+   * rendered at the same time. Every child with at least `threshold` bytes of
+   * markup before escaping is rendered into a string of its own by a
+   * task: the large children are split into runs of consecutive ones with
+   * about the same estimated size, one run per hardware thread. Meanwhile the
+   * calling thread walks the children in order, rendering the small ones into
+   * the writer's buffer as write() does, and appending each large one as soon
+   * as its run is done. Without large children, this is simply write().
+   */
+  HtmlWriter &write_parallel(Element const &root,
+                             std::size_t threshold = 1 << 16) {
+    std::vector<std::size_t> large;
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < root.children_.size(); ++i) {
+      if (root.children_[i].size_ >= threshold) {
+        large.push_back(i);
+        total += root.children_[i].size_;
+      }
+    }
+    if (large.empty()) return write(root);
+
+    std::vector<std::string> outputs(large.size());
+    std::vector<std::future<void> > tasks;
+    // EN: The task that renders large child `n`, counting large ones only.
+    std::vector<std::size_t> task_of(large.size());
+    std::size_t groups =
+        std::min<std::size_t>(large.size(), hardware_threads());
+    std::size_t begin = 0, done = 0;
+    for (std::size_t group = 1; group <= groups; ++group) {
+      // EN: Every run gets at least one child, and ends once the runs so far
+      // cover their share of the estimated markup.
+      std::size_t end = begin;
+      do {
+        done += root.children_[large[end++]].size_;
+      } while (end < large.size() - (groups - group) &&
+               done < total / groups * group);
+      if (group == groups) end = large.size();
+      for (std::size_t n = begin; n < end; ++n) task_of[n] = tasks.size();
+      tasks.push_back(std::async(
+          std::launch::async, [&root, &large, &outputs, begin, end]() {
+            std::vector<Frame> stack;
+            for (std::size_t n = begin; n < end; ++n) {
+              StringSink sink(outputs[n]);
+              render(root.children_[large[n]], sink, stack);
+            }
+          }));
+      begin = end;
+    }
+
+    open(root, *this);
+    std::size_t next = 0;
+    for (std::size_t i = 0; i < root.children_.size(); ++i) {
+      if (next < large.size() && large[next] == i) {
+        if (tasks[task_of[next]].valid()) tasks[task_of[next]].get();
+        append(outputs[next].data(), outputs[next].size());
+        ++next;
+      } else {
+        render(root.children_[i], *this, stack_);
+      }
+    }
+    TagLiteral const &literal = tag_literal(root.tag_);
+    append(literal.close, literal.close_size);
+    return *this;
+  }
+#endif
+
+  /**
+   * EN: Returns false if any write has failed since the writer was created.
+   */
+  bool flush() {
+    if (size_ != 0) write_all(&buffer_[0], size_);
+    size_ = 0;
+    return error_ == 0;
+  }
+
+  /**
+   * EN: The errno of the first failed write, or 0.
+   */
+  int error() const { return error_; }
+
+ private:
+  struct Frame {
+    explicit Frame(Element const *e) : element(e), next_child(0) {}
+    Element const *element;
+    std::size_t next_child;
+  };
+
+  /**
+   * EN: The traversal is written against any sink with an append() method, so
+   * the same code renders into the writer's buffer or into a plain string.
+   */
+  struct StringSink {
+    explicit StringSink(std::string &o) : out(o) {}
+    void append(char const *data, std::size_t size) { out.append(data, size); }
+    std::string &out;
+  };
+
+  template <typename Sink>
+  static void render(Element const &root, Sink &sink,
+                     std::vector<Frame> &stack) {
+    stack.push_back(Frame(&root));
+    open(root, sink);
+    while (!stack.empty()) {
+      Frame &top = stack.back();
+      if (top.next_child < top.element->children_.size()) {
+        Element const &next = top.element->children_[top.next_child++];
+        stack.push_back(Frame(&next));
+        open(next, sink);
+      } else {
+        TagLiteral const &literal = tag_literal(top.element->tag_);
+        sink.append(literal.close, literal.close_size);
+        stack.pop_back();
+      }
+    }
+  }
+
+  template <typename Sink>
+  static void open(Element const &e, Sink &sink) {
+    TagLiteral const &literal = tag_literal(e.tag_);
+    sink.append(literal.open, literal.open_size);
+    if (!e.content_.empty()) {
+      append_escaped(e.content_.data(), e.content_.size(), sink);
+    } else {
+      sink.append("\n", 1);
+    }
+  }
+
+  template <typename Sink>
+  static void append_escaped(char const *data, std::size_t size, Sink &sink) {
+    for (;;) {
+      std::size_t clean = find_special(data, size);
+      sink.append(data, clean);
+      if (clean == size) return;
+      switch (data[clean]) {
+        case '<': sink.append("&lt;", 4); break;
+        case '>': sink.append("&gt;", 4); break;
+        case '&': sink.append("&amp;", 5); break;
+        case '"': sink.append("&quot;", 6); break;
+        default: sink.append("&#39;", 5); break;
+      }
+      data += clean + 1;
+      size -= clean + 1;
+    }
+  }
+
+  template <typename Sink>
+  void render_children(Element const &e, RenderCache &cache, Sink &sink) {
+    open(e, sink);
+    for (std::size_t i = 0; i < e.children_.size(); ++i) {
+      render_cached(e.children_[i], cache, sink);
+    }
+    TagLiteral const &literal = tag_literal(e.tag_);
+    sink.append(literal.close, literal.close_size);
+  }
+
+  template <typename Sink>
+  void render_cached(Element const &e, RenderCache &cache, Sink &sink) {
+    // EN: Every descendant of a small element is smaller still.
+    if (e.size_ < cache.min_size_) {
+      render(e, sink, stack_);
+      return;
+    }
+    RenderCache::Entry *hit = cache.find(e.hash_);
+    if (hit != 0 && hit->check == e.check_ && hit->tag == e.tag_ &&
+        hit->children == e.children_.size() && hit->content == e.content_) {
+      sink.append(hit->markup.data(), hit->markup.size());
+      return;
+    }
+    // EN: Rendered aside rather than straight into the entry: a descendant
+    // with a colliding hash would store into the same entry meanwhile.
+    std::string markup;
+    markup.reserve(e.size_);
+    StringSink out(markup);
+    render_children(e, cache, out);
+    sink.append(markup.data(), markup.size());
+    RenderCache::Entry &entry = cache.store(e.hash_);
+    entry.tag = e.tag_;
+    entry.content = e.content_;
+    entry.children = e.children_.size();
+    entry.check = e.check_;
+    entry.markup.swap(markup);
+  }
+
+#ifdef HAS_STD_THREAD
+  // EN: hardware_concurrency() may report 0 when it cannot tell.
+  static std::size_t hardware_threads() {
+    unsigned threads = std::thread::hardware_concurrency();
+    return threads == 0 ? 1 : threads;
+  }
+#endif
+
+  void append(char const *data, std::size_t size) {
+    if (size == 0) return;
+    if (size > buffer_.size() - size_) {
+      flush();
+      if (size > buffer_.size()) {
+        write_all(data, size);
+        return;
+      }
+    }
+    std::memcpy(&buffer_[size_], data, size);
+    size_ += size;
+  }
+
+  void write_all(char const *data, std::size_t size) {
+    std::size_t written = 0;
+    while (error_ == 0 && written < size) {
+#ifdef _WIN32
+      long n = _write(fd_, data + written, static_cast<unsigned>(size - written));
+#else
+      long n = static_cast<long>(::write(fd_, data + written, size - written));
+#endif
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) {
+        error_ = n < 0 ? errno : EIO;
+        return;
+      }
+      written += static_cast<std::size_t>(n);
+    }
+  }
+
+  int fd_;
+  std::vector<char> buffer_;
+  std::size_t size_;
+  int error_;
+  std::vector<Frame> stack_;
+};
+
 }  // namespace html
 
+#ifdef HAS_MOVE_SEMANTICS
+/**
+ * EN: A page of 200 sections with 100 paragraphs each, where every tick
+ * changes one paragraph. The ticks cycle through a few prebuilt pages, so
+ * only rendering is measured, once in full and once with a render cache.
+ */
+void benchmark_writer(benchmark::Harness &harness) {
+  std::vector<html::Element> pages;
+  for (int tick = 0; tick < 16; ++tick) {
+    html::ElementBuilder page(TAG_SCOPE()::body);
+    page.add_child(TAG_SCOPE()::h1, "Title of the Page");
+    for (int section = 0; section < 200; ++section) {
+      html::ElementBuilder builder(TAG_SCOPE()::h2);
+      for (int paragraph = 0; paragraph < 100; ++paragraph) {
+        bool changed = section == tick * 13 && paragraph == tick;
+        builder.add_child(TAG_SCOPE()::p,
+                          "Paragraph " + std::to_string(paragraph) +
+                              (changed ? ", changed on this tick" : ""));
+      }
+      page.add_child(std::move(builder).build());
+    }
+    pages.push_back(std::move(page).build());
+  }
+
+#ifdef _WIN32
+  int fd = ::open("NUL", O_WRONLY);
+#else
+  int fd = ::open("/dev/null", O_WRONLY);
+#endif
+  int const ticks = 200;
+  {
+    html::HtmlWriter writer(fd);
+    harness.Run("write a page", ticks, [&] {
+      for (int i = 0; i < ticks; ++i) writer.write(pages[i % pages.size()]);
+    });
+  }
+  {
+    html::HtmlWriter writer(fd);
+    html::RenderCache cache;
+    harness.Run("write a page with a render cache", ticks, [&] {
+      for (int i = 0; i < ticks; ++i) {
+        writer.write(pages[i % pages.size()], cache);
+      }
+    });
+  }
+#ifdef _WIN32
+  _close(fd);
+#else
+  ::close(fd);
+#endif
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1 && std::string(argv[1]) == "--benchmark") {
+    benchmark::Harness harness(argc, argv);
+    benchmark_writer(harness);
+    return harness.Finish();
+  }
+#else
 int main() {
+#endif
   html::Element body =
       html::ElementBuilder(TAG_SCOPE()::body)
           .add_child(TAG_SCOPE()::h1, "Title of the Page")
@@ -168,4 +934,34 @@ int main() {
       /* ... */;
 
   std::cout << body;
+
+  html::Document document;
+  document.reserve(6, 128);
+  html::DocumentBuilder(document, TAG_SCOPE()::body)
+      .add_child(TAG_SCOPE()::h1, "Title of the Page")
+      .add_child(TAG_SCOPE()::h2, "Subtitle A")
+      .add_child(TAG_SCOPE()::p, "Lorem ipsum dolor sit amet, ...")
+      .add_child(TAG_SCOPE()::h2, "Subtitle B")
+      .add_child(TAG_SCOPE()::p, "... consectetur adipiscing elit.")
+      /* ... */;
+
+  std::cout << document << std::flush;
+
+  html::HtmlWriter writer(1 /* stdout */);
+#ifdef HAS_STD_THREAD
+  writer.write_parallel(body, 32);
+#else
+  writer.write(body);
+#endif
+
+  // EN: A page rebuilt on every data tick. With a render cache, the writer
+  // only renders the elements that changed since the previous tick.
+  html::RenderCache cache(0);
+  for (int tick = 1; tick <= 2; ++tick) {
+    html::Element page =
+        html::ElementBuilder(TAG_SCOPE()::body)
+            .add_child(TAG_SCOPE()::h1, "Title of the Page")
+            .add_child(TAG_SCOPE()::p, tick == 1 ? "Tick 1" : "Tick 2");
+    writer.write(page, cache);
+  }
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include <string>
 #include <vector>
 
+#include "../../Benchmark/benchmark.h"
+
 /**
  * EN: Chain of Responsibility Design Pattern
  *
@@ -125,7 +127,36 @@ void ClientCode(Handler &handler) {
  *
  * RU: Другая часть клиентского кода создает саму цепочку.
  */
-int main() {
+/**
+ * EN: Run with `--benchmark` to time requests that the first handler takes,
+ * that the second one takes, and that pass through the whole chain untouched.
+ *
+ * RU: Запустите с `--benchmark`, чтобы замерить запросы, которые берёт первый
+ * обработчик, которые берёт второй, и которые проходят всю цепочку
+ * нетронутыми.
+ */
+void Benchmark(benchmark::Harness &harness) {
+  MonkeyHandler monkey;
+  SquirrelHandler squirrel;
+  DogHandler dog;
+  monkey.SetNext(&squirrel)->SetNext(&dog);
+  const int requests = 1000000;
+  for (const std::string request : {"Banana", "Nut", "Cup of coffee"}) {
+    harness.Run("Handle(\"" + request + "\")", requests, [&] {
+      for (int i = 0; i < requests; ++i) {
+        benchmark::DoNotOptimize(monkey.Handle(request));
+      }
+    });
+  }
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1 && std::string(argv[1]) == "--benchmark") {
+    benchmark::Harness harness(argc, argv);
+    Benchmark(harness);
+    return harness.Finish();
+  }
+
   MonkeyHandler *monkey = new MonkeyHandler;
   SquirrelHandler *squirrel = new SquirrelHandler;
   DogHandler *dog = new DogHandler;
@@ -1,6 +1,8 @@
 #include <iostream>
 #include <string>
 
+#include "../../Benchmark/benchmark.h"
+
 /**
  * EN: Command Design Pattern
  *
@@ -165,7 +167,45 @@ class Invoker {
  * RU: Клиентский код может параметризовать отправителя любыми командами.
  */
 
-int main() {
+/**
+ * EN: Run with `--benchmark` to time setting up an Invoker with its commands,
+ * and the Invoker running them. The output is thrown away.
+ *
+ * RU: Запустите с `--benchmark`, чтобы замерить настройку Отправителя с его
+ * командами и выполнение их Отправителем. Вывод отбрасывается.
+ */
+void Benchmark(benchmark::Harness &harness) {
+  const int calls = 100000;
+  Receiver receiver;
+  harness.Budget("set up an Invoker", 3);
+  harness.Run("set up an Invoker", calls, [&] {
+    for (int i = 0; i < calls; ++i) {
+      Invoker *invoker = new Invoker;
+      invoker->SetOnStart(new SimpleCommand("Say Hi!"));
+      invoker->SetOnFinish(new ComplexCommand(&receiver, "Send email", "Save report"));
+      delete invoker;
+    }
+  });
+
+  Invoker invoker;
+  invoker.SetOnStart(new SimpleCommand("Say Hi!"));
+  invoker.SetOnFinish(new ComplexCommand(&receiver, "Send email", "Save report"));
+  harness.Budget("DoSomethingImportant", 0);
+  harness.Run("DoSomethingImportant", calls, [&] {
+    benchmark::MuteOutput mute;
+    for (int i = 0; i < calls; ++i) {
+      invoker.DoSomethingImportant();
+    }
+  });
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1 && std::string(argv[1]) == "--benchmark") {
+    benchmark::Harness harness(argc, argv);
+    Benchmark(harness);
+    return harness.Finish();
+  }
+
   Invoker *invoker = new Invoker;
   invoker->SetOnStart(new SimpleCommand("Say Hi!"));
   Receiver *receiver = new Receiver;
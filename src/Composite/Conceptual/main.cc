@@ -3,6 +3,8 @@
 #include <iostream>
 #include <list>
 #include <string>
+
+#include "../../Benchmark/benchmark.h"
 /**
  * EN: Composite Design Pattern
  *
@@ -200,7 +202,63 @@ void ClientCode2(Component *component1, Component *component2) {
  * компоненты-листья...
  */
 
-int main() {
+/**
+ * EN: Run with `--benchmark` to time building the tree above and walking it.
+ * Every node is a separate allocation, and so is every list node that links
+ * it to its parent.
+ *
+ * RU: Запустите с `--benchmark`, чтобы замерить построение приведённого выше
+ * дерева и его обход. Каждый узел — отдельное выделение памяти, как и каждый
+ * узел списка, который связывает его с родителем.
+ */
+void Benchmark(benchmark::Harness &harness) {
+  const int trees = 100000;
+  harness.Budget("build and delete a tree", 11);
+  harness.Run("build and delete a tree", trees, [&] {
+    for (int i = 0; i < trees; ++i) {
+      Component *tree = new Composite;
+      Component *branch1 = new Composite;
+      Component *branch2 = new Composite;
+      Component *leaves[] = {new Leaf, new Leaf, new Leaf};
+      branch1->Add(leaves[0]);
+      branch1->Add(leaves[1]);
+      branch2->Add(leaves[2]);
+      tree->Add(branch1);
+      tree->Add(branch2);
+      delete tree;
+      delete branch1;
+      delete branch2;
+      for (Component *leaf : leaves) {
+        delete leaf;
+      }
+    }
+  });
+
+  Composite tree, branch1, branch2;
+  Leaf leaves[3];
+  branch1.Add(&leaves[0]);
+  branch1.Add(&leaves[1]);
+  branch2.Add(&leaves[2]);
+  tree.Add(&branch1);
+  tree.Add(&branch2);
+  // EN: Operation() builds its result by concatenating strings.
+  //
+  // RU: Operation() строит свой результат конкатенацией строк.
+  harness.Budget("Operation on the tree", 4);
+  harness.Run("Operation on the tree", trees, [&] {
+    for (int i = 0; i < trees; ++i) {
+      benchmark::DoNotOptimize(tree.Operation());
+    }
+  });
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1 && std::string(argv[1]) == "--benchmark") {
+    benchmark::Harness harness(argc, argv);
+    Benchmark(harness);
+    return harness.Finish();
+  }
+
   Component *simple = new Leaf;
   std::cout << "Client: I've got a simple component:\n";
   ClientCode(simple);
@@ -1,6 +1,8 @@
 #include <iostream>
 #include <string>
 
+#include "../../Benchmark/benchmark.h"
+
 /**
  * EN: Decorator Design Pattern
  *
@@ -124,7 +126,37 @@ void ClientCode(Component* component) {
   // ...
 }
 
-int main() {
+/**
+ * EN: Run with `--benchmark` to time Operation() on the plain component and
+ * through both decorators.
+ *
+ * RU: Запустите с `--benchmark`, чтобы замерить Operation() на простом
+ * компоненте и через оба декоратора.
+ */
+void Benchmark(benchmark::Harness &harness) {
+  ConcreteComponent simple;
+  ConcreteDecoratorA decorator1(&simple);
+  ConcreteDecoratorB decorator2(&decorator1);
+  const int calls = 1000000;
+  harness.Run("Operation on the component", calls, [&] {
+    for (int i = 0; i < calls; ++i) {
+      benchmark::DoNotOptimize(simple.Operation());
+    }
+  });
+  harness.Run("Operation through two decorators", calls, [&] {
+    for (int i = 0; i < calls; ++i) {
+      benchmark::DoNotOptimize(decorator2.Operation());
+    }
+  });
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1 && std::string(argv[1]) == "--benchmark") {
+    benchmark::Harness harness(argc, argv);
+    Benchmark(harness);
+    return harness.Finish();
+  }
+
   /**
  * EN: This way the client code can support both simple components...
  *
@@ -1,6 +1,8 @@
 #include <iostream>
 #include <string>
 
+#include "../../Benchmark/benchmark.h"
+
 /**
  * EN: Factory Method Design Pattern
  *
@@ -154,7 +156,31 @@ void ClientCode(const Creator& creator) {
  * среды.
  */
 
-int main() {
+/**
+ * EN: Run with `--benchmark` to time the Creator's SomeOperation(), which makes
+ * a new product on every call.
+ *
+ * RU: Запустите с `--benchmark`, чтобы замерить SomeOperation() Создателя,
+ * который создаёт новый продукт при каждом вызове.
+ */
+void Benchmark(benchmark::Harness &harness) {
+  const int calls = 1000000;
+  ConcreteCreator1 creator;
+  harness.Budget("SomeOperation", 4);
+  harness.Run("SomeOperation", calls, [&] {
+    for (int i = 0; i < calls; ++i) {
+      benchmark::DoNotOptimize(creator.SomeOperation());
+    }
+  });
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1 && std::string(argv[1]) == "--benchmark") {
+    benchmark::Harness harness(argc, argv);
+    Benchmark(harness);
+    return harness.Finish();
+  }
+
   std::cout << "App: Launched with the ConcreteCreator1.\n";
   Creator* creator = new ConcreteCreator1();
   ClientCode(*creator);
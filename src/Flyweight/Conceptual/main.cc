@@ -3,6 +3,8 @@
 #include <vector>
 #include <unordered_map>
 
+#include "../../Benchmark/benchmark.h"
+
 /**
  * EN: Flyweight Design Pattern
  *
@@ -178,8 +180,36 @@ void AddCarToPoliceDatabase(
  * на этапе инициализации приложения.
  */
 
-int main()
+/**
+ * EN: Run with `--benchmark` to time adding a car whose shared state already
+ * has a flyweight. The output is thrown away.
+ *
+ * RU: Запустите с `--benchmark`, чтобы замерить добавление машины, для общего
+ * состояния которой уже есть легковес. Вывод отбрасывается.
+ */
+void Benchmark(benchmark::Harness &harness)
 {
+    FlyweightFactory factory({{"BMW", "M5", "red"}, {"BMW", "X6", "white"}});
+    const int cars = 1000000;
+    harness.Run("AddCarToPoliceDatabase, existing flyweight", cars, [&]
+    {
+        benchmark::MuteOutput mute;
+        for (int i = 0; i < cars; ++i)
+        {
+            AddCarToPoliceDatabase(factory, "CL234IR", "James Doe", "BMW", "M5", "red");
+        }
+    });
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && std::string(argv[1]) == "--benchmark")
+    {
+        benchmark::Harness harness(argc, argv);
+        Benchmark(harness);
+        return harness.Finish();
+    }
+
     FlyweightFactory *factory = new FlyweightFactory({{"Chevrolet", "Camaro2018", "pink"}, {"Mercedes Benz", "C300", "black"}, {"Mercedes Benz", "C500", "red"}, {"BMW", "M5", "red"}, {"BMW", "X6", "white"}});
     factory->ListFlyweights();
 
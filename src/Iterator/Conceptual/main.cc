@@ -14,6 +14,8 @@
 #include <string>
 #include <vector>
 
+#include "../../Benchmark/benchmark.h"
+
 /**
      * EN: C++ has its own implementation of iterator that works with 
      * a different generics containers defined by the standard library.
@@ -126,7 +128,39 @@ void ClientCode() {
   delete it2;
 }
 
-int main() {
+/**
+ * EN: Run with `--benchmark` to time a walk over a container of 1000 integers
+ * through the iterator.
+ *
+ * RU: Запустите с `--benchmark`, чтобы замерить обход контейнера из 1000
+ * целых чисел через итератор.
+ */
+void Benchmark(benchmark::Harness &harness) {
+  Container<int> cont;
+  for (int i = 0; i < 1000; i++) {
+    cont.Add(i);
+  }
+  Iterator<int, Container<int>> *it = cont.CreateIterator();
+  const int walks = 10000;
+  harness.Run("Iterator over 1000 ints", walks * 1000, [&] {
+    for (int i = 0; i < walks; ++i) {
+      int sum = 0;
+      for (it->First(); !it->IsDone(); it->Next()) {
+        sum += *it->Current();
+      }
+      benchmark::DoNotOptimize(sum);
+    }
+  });
+  delete it;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1 && std::string(argv[1]) == "--benchmark") {
+    benchmark::Harness harness(argc, argv);
+    Benchmark(harness);
+    return harness.Finish();
+  }
+
   ClientCode();
   return 0;
 }
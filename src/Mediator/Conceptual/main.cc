@@ -1,6 +1,9 @@
 
 #include <iostream>
 #include <string>
+
+#include "../../Benchmark/benchmark.h"
+
 /**
  * EN: Mediator Design Pattern
  *
@@ -131,7 +134,39 @@ void ClientCode() {
   delete mediator;
 }
 
-int main() {
+/**
+ * EN: Run with `--benchmark` to time operations A and D, with the reactions
+ * the mediator triggers. The output is thrown away.
+ *
+ * RU: Запустите с `--benchmark`, чтобы замерить операции A и D вместе с
+ * реакциями, которые запускает посредник. Вывод отбрасывается.
+ */
+void Benchmark(benchmark::Harness &harness) {
+  Component1 c1;
+  Component2 c2;
+  ConcreteMediator mediator(&c1, &c2);
+  const int calls = 1000000;
+  harness.Run("DoA", calls, [&] {
+    benchmark::MuteOutput mute;
+    for (int i = 0; i < calls; ++i) {
+      c1.DoA();
+    }
+  });
+  harness.Run("DoD", calls, [&] {
+    benchmark::MuteOutput mute;
+    for (int i = 0; i < calls; ++i) {
+      c2.DoD();
+    }
+  });
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1 && std::string(argv[1]) == "--benchmark") {
+    benchmark::Harness harness(argc, argv);
+    Benchmark(harness);
+    return harness.Finish();
+  }
+
   ClientCode();
   return 0;
 }
@@ -4,6 +4,8 @@
 #include <string>
 #include <vector>
 
+#include "../../Benchmark/benchmark.h"
+
 /**
  * EN: Memento Design Pattern
  *
@@ -225,7 +227,39 @@ void ClientCode() {
   delete caretaker;
 }
 
-int main() {
+/**
+ * EN: Run with `--benchmark` to time the Originator saving its state into a
+ * memento and restoring it again. The output is thrown away.
+ *
+ * RU: Запустите с `--benchmark`, чтобы замерить, как Создатель сохраняет своё
+ * состояние в снимок и снова восстанавливает его. Вывод отбрасывается.
+ */
+void Benchmark(benchmark::Harness &harness) {
+  const int calls = 100000;
+  Originator *originator;
+  {
+    benchmark::MuteOutput mute;
+    originator = new Originator("Super-duper-super-puper-super.");
+  }
+  harness.Budget("Save and Restore", 5);
+  harness.Run("Save and Restore", calls, [&] {
+    benchmark::MuteOutput mute;
+    for (int i = 0; i < calls; ++i) {
+      Memento *memento = originator->Save();
+      originator->Restore(memento);
+      delete memento;
+    }
+  });
+  delete originator;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1 && std::string(argv[1]) == "--benchmark") {
+    benchmark::Harness harness(argc, argv);
+    Benchmark(harness);
+    return harness.Finish();
+  }
+
   std::srand(static_cast<unsigned int>(std::time(NULL)));
   ClientCode();
   return 0;
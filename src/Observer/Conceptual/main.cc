@@ -25,6 +25,8 @@
 #include <list>
 #include <string>
 
+#include "../../Benchmark/benchmark.h"
+
 class IObserver {
  public:
   virtual ~IObserver(){};
@@ -166,7 +168,45 @@ void ClientCode() {
   delete subject;
 }
 
-int main() {
+/**
+ * EN: Run with `--benchmark` to time a message sent to ten observers. The
+ * output is thrown away.
+ *
+ * RU: Запустите с `--benchmark`, чтобы замерить сообщение, отправленное десяти
+ * наблюдателям. Вывод отбрасывается.
+ */
+void Benchmark(benchmark::Harness &harness) {
+  Subject *subject;
+  std::list<Observer> *observers;
+  {
+    benchmark::MuteOutput mute;
+    subject = new Subject;
+    observers = new std::list<Observer>;
+    for (int i = 0; i < 10; ++i) {
+      observers->emplace_back(*subject);
+    }
+  }
+  const int messages = 100000;
+  harness.Run("CreateMessage to 10 observers", messages, [&] {
+    benchmark::MuteOutput mute;
+    for (int i = 0; i < messages; ++i) {
+      subject->CreateMessage("Hello World! :D");
+    }
+  });
+  {
+    benchmark::MuteOutput mute;
+    delete observers;
+    delete subject;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1 && std::string(argv[1]) == "--benchmark") {
+    benchmark::Harness harness(argc, argv);
+    Benchmark(harness);
+    return harness.Finish();
+  }
+
   ClientCode();
   return 0;
 }
@@ -2,6 +2,8 @@
 #include <string>
 #include <unordered_map>
 
+#include "../../Benchmark/benchmark.h"
+
 using std::string;
 
 // EN: Prototype Design Pattern
@@ -147,7 +149,32 @@ void Client(PrototypeFactory &prototype_factory) {
   delete prototype;
 }
 
-int main() {
+/**
+ * EN: Run with `--benchmark` to time cloning a prototype from the factory.
+ *
+ * RU: Запустите с `--benchmark`, чтобы замерить клонирование прототипа из
+ * фабрики.
+ */
+void Benchmark(benchmark::Harness &harness) {
+  const int clones = 1000000;
+  PrototypeFactory prototype_factory;
+  harness.Budget("CreatePrototype", 1);
+  harness.Run("CreatePrototype", clones, [&] {
+    for (int i = 0; i < clones; ++i) {
+      Prototype *prototype = prototype_factory.CreatePrototype(i % 2 == 0 ? Type::PROTOTYPE_1 : Type::PROTOTYPE_2);
+      benchmark::DoNotOptimize(prototype);
+      delete prototype;
+    }
+  });
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1 && std::string(argv[1]) == "--benchmark") {
+    benchmark::Harness harness(argc, argv);
+    Benchmark(harness);
+    return harness.Finish();
+  }
+
   PrototypeFactory *prototype_factory = new PrototypeFactory();
   Client(*prototype_factory);
   delete prototype_factory;
@@ -1,4 +1,8 @@
 #include <iostream>
+#include <string>
+
+#include "../../Benchmark/benchmark.h"
+
 /**
  * EN: Proxy Design Pattern
  *
@@ -119,7 +123,38 @@ void ClientCode(const Subject &subject) {
   // ...
 }
 
-int main() {
+/**
+ * EN: Run with `--benchmark` to compare a request to the real subject with
+ * the same request through the proxy. The output is thrown away.
+ *
+ * RU: Запустите с `--benchmark`, чтобы сравнить запрос к реальному субъекту с
+ * тем же запросом через заместителя. Вывод отбрасывается.
+ */
+void Benchmark(benchmark::Harness &harness) {
+  RealSubject real_subject;
+  Proxy proxy(&real_subject);
+  const int requests = 1000000;
+  harness.Run("Request on the real subject", requests, [&] {
+    benchmark::MuteOutput mute;
+    for (int i = 0; i < requests; ++i) {
+      ClientCode(real_subject);
+    }
+  });
+  harness.Run("Request through the proxy", requests, [&] {
+    benchmark::MuteOutput mute;
+    for (int i = 0; i < requests; ++i) {
+      ClientCode(proxy);
+    }
+  });
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1 && std::string(argv[1]) == "--benchmark") {
+    benchmark::Harness harness(argc, argv);
+    Benchmark(harness);
+    return harness.Finish();
+  }
+
   std::cout << "Client: Executing the client code with a real subject:\n";
   RealSubject *real_subject = new RealSubject;
   ClientCode(*real_subject);
@@ -2,6 +2,8 @@
 #include <string>
 #include <thread>
 
+#include "../../../Benchmark/benchmark.h"
+
 /**
  * EN: Singleton Design Pattern
  *
@@ -128,8 +130,34 @@ void ThreadBar(){
 }
 
 
-int main()
+/**
+ * EN: Run with `--benchmark` to time GetInstance() once the singleton exists.
+ *
+ * RU: Запустите с `--benchmark`, чтобы замерить GetInstance(), когда
+ * одиночка уже создан.
+ */
+void Benchmark(benchmark::Harness &harness)
 {
+    const int calls = 10000000;
+    Singleton::GetInstance("FOO");
+    harness.Run("GetInstance", calls, [&]
+    {
+        for (int i = 0; i < calls; ++i)
+        {
+            benchmark::DoNotOptimize(Singleton::GetInstance("FOO"));
+        }
+    });
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && std::string(argv[1]) == "--benchmark")
+    {
+        benchmark::Harness harness(argc, argv);
+        Benchmark(harness);
+        return harness.Finish();
+    }
+
     std::cout <<"If you see the same value, then singleton was reused (yay!\n" <<
                 "If you see different values, then 2 singletons were created (booo!!)\n\n" <<
                 "RESULT:\n";   
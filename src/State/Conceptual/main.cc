@@ -1,5 +1,8 @@
 #include <iostream>
+#include <string>
 #include <typeinfo>
+
+#include "../../Benchmark/benchmark.h"
 /**
  * EN: State Design Pattern
  *
@@ -147,7 +150,41 @@ void ClientCode() {
   delete context;
 }
 
-int main() {
+/**
+ * EN: Run with `--benchmark` to time a round trip from ConcreteStateA to
+ * ConcreteStateB and back. The output is thrown away.
+ *
+ * RU: Запустите с `--benchmark`, чтобы замерить переход из ConcreteStateA в
+ * ConcreteStateB и обратно. Вывод отбрасывается.
+ */
+void Benchmark(benchmark::Harness &harness) {
+  const int round_trips = 1000000;
+  Context *context;
+  {
+    benchmark::MuteOutput mute;
+    context = new Context(new ConcreteStateA);
+  }
+  harness.Budget("Request1 and Request2", 2);
+  harness.Run("Request1 and Request2", round_trips, [&] {
+    benchmark::MuteOutput mute;
+    for (int i = 0; i < round_trips; ++i) {
+      context->Request1();
+      context->Request2();
+    }
+  });
+  {
+    benchmark::MuteOutput mute;
+    delete context;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1 && std::string(argv[1]) == "--benchmark") {
+    benchmark::Harness harness(argc, argv);
+    Benchmark(harness);
+    return harness.Finish();
+  }
+
   ClientCode();
   return 0;
 }
@@ -2,6 +2,9 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <memory>
+
+#include "../../Benchmark/benchmark.h"
 
 /**
  * EN: Strategy Design Pattern
@@ -145,8 +148,41 @@ void clientCode()
     context.doSomeBusinessLogic();
 }
 
-int main()
+/**
+ * EN: Run with `--benchmark` to time both strategies on the sample data.
+ *
+ * RU: Запустите с `--benchmark`, чтобы замерить обе стратегии на примере
+ * данных.
+ */
+void Benchmark(benchmark::Harness &harness)
+{
+    const int calls = 1000000;
+    ConcreteStrategyA normal;
+    ConcreteStrategyB reverse;
+    const Strategy *strategies[] = {&normal, &reverse};
+    const char *names[] = {"doAlgorithm, normal sorting", "doAlgorithm, reverse sorting"};
+    for (int s = 0; s < 2; ++s)
+    {
+        const Strategy *strategy = strategies[s];
+        harness.Run(names[s], calls, [&]
+        {
+            for (int i = 0; i < calls; ++i)
+            {
+                benchmark::DoNotOptimize(strategy->doAlgorithm("aecbd"));
+            }
+        });
+    }
+}
+
+int main(int argc, char *argv[])
 {
+    if (argc > 1 && std::string(argv[1]) == "--benchmark")
+    {
+        benchmark::Harness harness(argc, argv);
+        Benchmark(harness);
+        return harness.Finish();
+    }
+
     clientCode();
     return 0;
 }
\ No newline at end of file
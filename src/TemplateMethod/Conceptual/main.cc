@@ -1,4 +1,7 @@
 #include <iostream>
+#include <string>
+
+#include "../../Benchmark/benchmark.h"
 
 /**
  * EN: Template Method Design Pattern
@@ -131,7 +134,38 @@ void ClientCode(AbstractClass *class_) {
   // ...
 }
 
-int main() {
+/**
+ * EN: Run with `--benchmark` to time the template method of both concrete
+ * classes. The output is thrown away.
+ *
+ * RU: Запустите с `--benchmark`, чтобы замерить шаблонный метод обоих
+ * конкретных классов. Вывод отбрасывается.
+ */
+void Benchmark(benchmark::Harness &harness) {
+  ConcreteClass1 concrete_class1;
+  ConcreteClass2 concrete_class2;
+  const int calls = 1000000;
+  harness.Run("TemplateMethod of ConcreteClass1", calls, [&] {
+    benchmark::MuteOutput mute;
+    for (int i = 0; i < calls; ++i) {
+      ClientCode(&concrete_class1);
+    }
+  });
+  harness.Run("TemplateMethod of ConcreteClass2", calls, [&] {
+    benchmark::MuteOutput mute;
+    for (int i = 0; i < calls; ++i) {
+      ClientCode(&concrete_class2);
+    }
+  });
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1 && std::string(argv[1]) == "--benchmark") {
+    benchmark::Harness harness(argc, argv);
+    Benchmark(harness);
+    return harness.Finish();
+  }
+
   std::cout << "Same client code can work with different subclasses:\n";
   ConcreteClass1 *concreteClass1 = new ConcreteClass1;
   ClientCode(concreteClass1);
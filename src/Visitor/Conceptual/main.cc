@@ -1,6 +1,8 @@
 #include <array>
+#include <cstddef>
 #include <iostream>
 #include <string>
+#include <vector>
 
 /**
  * EN: Visitor Design Pattern
@@ -24,11 +26,24 @@
  */
 class ConcreteComponentA;
 class ConcreteComponentB;
+class ComponentBatch;
 
 class Visitor {
  public:
   virtual void VisitConcreteComponentA(const ConcreteComponentA *element) const = 0;
   virtual void VisitConcreteComponentB(const ConcreteComponentB *element) const = 0;
+  /**
+   * EN: The batch methods receive every component of one class at once, as a
+   * contiguous run of `count` elements. By default they simply visit the
+   * elements one by one; a visitor overrides them when it can do better.
+   *
+   * RU: Пакетные методы получают все компоненты одного класса сразу, в виде
+   * непрерывной последовательности из `count` элементов. По умолчанию они
+   * просто посещают элементы по одному; посетитель переопределяет их, когда
+   * может сделать это лучше.
+   */
+  virtual void VisitConcreteComponentsA(const ConcreteComponentA *const *elements, std::size_t count) const;
+  virtual void VisitConcreteComponentsB(const ConcreteComponentB *const *elements, std::size_t count) const;
 };
 
 /**
@@ -43,6 +58,52 @@ class Component {
  public:
   virtual ~Component() {}
   virtual void Accept(Visitor *visitor) const = 0;
+  virtual void AddToBatch(ComponentBatch *batch) const = 0;
+};
+
+/**
+ * EN: A batch sorts a collection of components by their concrete class once,
+ * using the same double dispatch as `Accept`. Afterwards, a visitor is applied
+ * to the whole batch with one call per class instead of two virtual calls per
+ * component, and each of those calls runs over components of a single class.
+ * Note that the components are therefore visited grouped by class rather than
+ * in their original order.
+ *
+ * RU: Пакет один раз сортирует набор компонентов по их конкретному классу,
+ * используя ту же двойную диспетчеризацию, что и `Accept`. После этого
+ * посетитель применяется ко всему пакету одним вызовом на класс вместо двух
+ * виртуальных вызовов на компонент, и каждый из этих вызовов проходит по
+ * компонентам одного класса. Обратите внимание, что поэтому компоненты
+ * посещаются сгруппированными по классу, а не в исходном порядке.
+ */
+class ComponentBatch {
+ public:
+  template <typename Iterator>
+  ComponentBatch(Iterator begin, Iterator end) {
+    for (Iterator it = begin; it != end; ++it) {
+      (*it)->AddToBatch(this);
+    }
+  }
+
+  void Add(const ConcreteComponentA *element) {
+    components_a_.push_back(element);
+  }
+  void Add(const ConcreteComponentB *element) {
+    components_b_.push_back(element);
+  }
+
+  void Accept(Visitor *visitor) const {
+    if (!components_a_.empty()) {
+      visitor->VisitConcreteComponentsA(components_a_.data(), components_a_.size());
+    }
+    if (!components_b_.empty()) {
+      visitor->VisitConcreteComponentsB(components_b_.data(), components_b_.size());
+    }
+  }
+
+ private:
+  std::vector<const ConcreteComponentA *> components_a_;
+  std::vector<const ConcreteComponentB *> components_b_;
 };
 
 /**
@@ -67,6 +128,9 @@ class ConcreteComponentA : public Component {
   void Accept(Visitor *visitor) const override {
     visitor->VisitConcreteComponentA(this);
   }
+  void AddToBatch(ComponentBatch *batch) const override {
+    batch->Add(this);
+  }
   /**
      * EN: Concrete Components may have special methods that don't exist in
      * their base class or interface. The Visitor is still able to use these
@@ -91,11 +155,26 @@ class ConcreteComponentB : public Component {
   void Accept(Visitor *visitor) const override {
     visitor->VisitConcreteComponentB(this);
   }
+  void AddToBatch(ComponentBatch *batch) const override {
+    batch->Add(this);
+  }
   std::string SpecialMethodOfConcreteComponentB() const {
     return "B";
   }
 };
 
+void Visitor::VisitConcreteComponentsA(const ConcreteComponentA *const *elements, std::size_t count) const {
+  for (std::size_t i = 0; i < count; ++i) {
+    VisitConcreteComponentA(elements[i]);
+  }
+}
+
+void Visitor::VisitConcreteComponentsB(const ConcreteComponentB *const *elements, std::size_t count) const {
+  for (std::size_t i = 0; i < count; ++i) {
+    VisitConcreteComponentB(elements[i]);
+  }
+}
+
 /**
  * EN: Concrete Visitors implement several versions of the same algorithm, which
  * can work with all concrete component classes.
@@ -122,6 +201,25 @@ class ConcreteVisitor1 : public Visitor {
   void VisitConcreteComponentB(const ConcreteComponentB *element) const override {
     std::cout << element->SpecialMethodOfConcreteComponentB() << " + ConcreteVisitor1\n";
   }
+
+  /**
+   * EN: Since the batch holds a single class, the loop calls the component's
+   * methods directly, with no dispatch left inside it.
+   *
+   * RU: Поскольку пакет содержит компоненты одного класса, цикл вызывает методы
+   * компонента напрямую, без какой-либо диспетчеризации внутри.
+   */
+  void VisitConcreteComponentsA(const ConcreteComponentA *const *elements, std::size_t count) const override {
+    for (std::size_t i = 0; i < count; ++i) {
+      std::cout << elements[i]->ExclusiveMethodOfConcreteComponentA() << " + ConcreteVisitor1\n";
+    }
+  }
+
+  void VisitConcreteComponentsB(const ConcreteComponentB *const *elements, std::size_t count) const override {
+    for (std::size_t i = 0; i < count; ++i) {
+      std::cout << elements[i]->SpecialMethodOfConcreteComponentB() << " + ConcreteVisitor1\n";
+    }
+  }
 };
 
 class ConcreteVisitor2 : public Visitor {
@@ -150,6 +248,19 @@ void ClientCode(std::array<const Component *, 2> components, Visitor *visitor) {
   // ...
 }
 
+/**
+ * EN: For large collections the client can sort the components into a batch
+ * once and then apply any number of visitors to it.
+ *
+ * RU: Для больших наборов клиент может один раз отсортировать компоненты в
+ * пакет, а затем применить к нему любое количество посетителей.
+ */
+void BatchClientCode(const ComponentBatch &batch, Visitor *visitor) {
+  // ...
+  batch.Accept(visitor);
+  // ...
+}
+
 int main() {
   std::array<const Component *, 2> components = {new ConcreteComponentA, new ConcreteComponentB};
   std::cout << "The client code works with all visitors via the base Visitor interface:\n";
@@ -159,6 +270,15 @@ int main() {
   std::cout << "It allows the same client code to work with different types of visitors:\n";
   ConcreteVisitor2 *visitor2 = new ConcreteVisitor2;
   ClientCode(components, visitor2);
+  std::cout << "\n";
+
+  std::array<const Component *, 4> many_components = {components[0], components[1], components[0], components[1]};
+  ComponentBatch batch(many_components.begin(), many_components.end());
+  std::cout << "A batch is visited with one call per component class:\n";
+  BatchClientCode(batch, visitor1);
+  std::cout << "\n";
+  std::cout << "Visitors without batch methods still work with batches:\n";
+  BatchClientCode(batch, visitor2);
 
   for (const Component *comp : components) {
     delete comp;
@@ -35,11 +35,45 @@
  * Pattern applied to multiple types.
  */
 
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <climits>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
 #include <iostream>
+#include <mutex>
+#include <optional>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <variant>
 #include <vector>
 
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+#endif
+
+#include "../../Benchmark/benchmark.h"
+
 /**
  * EN: Stable Low-Lying Data Structures for Food, Drink,...
  *
@@ -52,7 +86,8 @@
  * of their upcoming role within the \c std::variant union, that is, a forward
  * declaration of these classes is not sufficient. The public API consists of an
  * explicit constructor and the necessary access methods that are required by
- * the \c Serialiser Visitor.
+ * the \c Serialiser Visitor. The accessors hand out views of the members
+ * rather than copies, so visiting an item never allocates.
  */
 class Food {
 public:
@@ -62,9 +97,10 @@ public:
   explicit Food(std::string name, std::size_t calories, Label label)
       : name_{name}, calories_{calories}, label_{label} {}
 
-  auto name() const noexcept { return name_; }
+  std::string_view name() const noexcept { return name_; }
   auto calories() const noexcept { return calories_; }
-  auto label() const noexcept {
+  auto label_id() const noexcept { return label_; }
+  std::string_view label() const noexcept {
     switch (label_) {
     case Label::meat:
       return "meat";
@@ -93,9 +129,10 @@ public:
   explicit Drink(std::string name, std::size_t volume, Label label)
       : name_{name}, volume_{volume}, label_{label} {}
 
-  auto name() const noexcept { return name_; }
+  std::string_view name() const noexcept { return name_; }
   auto volume() const noexcept { return volume_; }
-  auto label() const noexcept {
+  auto label_id() const noexcept { return label_; }
+  std::string_view label() const noexcept {
     switch (label_) {
     case Label::alcoholic:
       return "alcholic";
@@ -140,16 +177,234 @@ private:
 using Item = std::variant<Food, Drink /* ... */>;
 using Menu = std::vector<Item>;
 
+/**
+ * EN: The position of type \c T among the alternatives of a \c std::variant,
+ * known at compile time.
+ */
+template <typename T, typename Variant> struct alternative_index;
+
+template <typename T, typename... Types>
+struct alternative_index<T, std::variant<Types...>> {
+  static constexpr std::size_t value = [] {
+    std::size_t index{0};
+    (void)(... && (std::is_same_v<T, Types> ? false : (++index, true)));
+    return index;
+  }();
+};
+
+template <typename T, typename Variant>
+inline constexpr std::size_t alternative_index_v =
+    alternative_index<T, Variant>::value;
+
+/**
+ * EN: Columnar Item Collection
+ *
+ * Every element of a \c Menu is as large as the largest \c Item type, and
+ * visiting it means a \c std::visit dispatch on its type. When a workload
+ * visits all items but does not care about their order, it is cheaper to keep
+ * each \c Item type in a contiguous column of its own: a visitor then runs as
+ * one tight loop per type, with no dispatch and no padding between items.
+ * Insertion order is still recorded, as the column and position of every
+ * item, for visitors that do need it.
+ */
+template <typename Variant> class Columns;
+
+template <typename... Types> class Columns<std::variant<Types...>> {
+public:
+  template <typename T> void push_back(T item) {
+    constexpr std::size_t column =
+        alternative_index_v<T, std::variant<Types...>>;
+    order_.push_back({column, std::get<column>(columns_).size()});
+    std::get<column>(columns_).push_back(std::move(item));
+  }
+  void push_back(std::variant<Types...> const &item) {
+    std::visit([this](auto const &value) { push_back(value); }, item);
+  }
+
+  std::size_t size() const noexcept { return order_.size(); }
+
+  template <typename T> std::vector<T> const &column() const noexcept {
+    return std::get<std::vector<T>>(columns_);
+  }
+
+  /**
+   * EN: Visits all items of the first type, then all of the second, etc.
+   */
+  template <typename Visitor> void visit_by_type(Visitor &&visitor) const {
+    std::apply(
+        [&](auto const &...column) {
+          (..., [&] {
+            for (auto const &item : column)
+              visitor(item);
+          }());
+        },
+        columns_);
+  }
+
+  /**
+   * EN: Visits all items in the order in which they were inserted.
+   */
+  template <typename Visitor> void visit_in_order(Visitor &&visitor) const {
+    visit_in_order(visitor, std::index_sequence_for<Types...>{});
+  }
+
+private:
+  struct Position {
+    std::size_t column;
+    std::size_t index;
+  };
+
+  template <typename Visitor, std::size_t... I>
+  void visit_in_order(Visitor &visitor, std::index_sequence<I...>) const {
+    for (auto const &position : order_)
+      (..., (position.column == I
+                 ? visitor(std::get<I>(columns_)[position.index])
+                 : void()));
+  }
+
+  std::tuple<std::vector<Types>...> columns_;
+  std::vector<Position> order_;
+};
+
+using ColumnarMenu = Columns<Item>;
+
+/**
+ * EN: Menu Index
+ *
+ * A read-only index for queries such as "all vegan food between 200 and 400
+ * calories" or "cold drinks by volume", which would otherwise be a full
+ * \c std::visit scan over the \c Menu. For every \c Item type it keeps the
+ * amount (calories or volume) of each item as a sorted column of (amount,
+ * position) pairs, so a range is found by binary search, and one bitmap per
+ * label over the item positions, so a label test is a single bit lookup.
+ * Query results are positions in the \c Menu, ordered by amount.
+ */
+class MenuIndex {
+public:
+  explicit MenuIndex(Menu const &menu) : words_{(menu.size() + 63) / 64} {
+    for (std::size_t position = 0; position < menu.size(); ++position)
+      std::visit([&](auto const &item) { add(item, position); },
+                 menu[position]);
+    for (auto *column : {&food_, &drinks_})
+      std::sort(column->sorted.begin(), column->sorted.end());
+  }
+
+  /**
+   * EN: Food with calories in [min, max] and any of the given labels (or any
+   * label at all, if none are given).
+   */
+  std::vector<std::size_t>
+  food(std::size_t min, std::size_t max,
+       std::initializer_list<Food::Label> labels = {}) const {
+    return query(food_, min, max, labels);
+  }
+
+  /**
+   * EN: Drinks with a volume in [min, max] and any of the given labels.
+   */
+  std::vector<std::size_t>
+  drinks(std::size_t min, std::size_t max,
+         std::initializer_list<Drink::Label> labels = {}) const {
+    return query(drinks_, min, max, labels);
+  }
+
+private:
+  using Bitmap = std::vector<std::uint64_t>;
+
+  struct Column {
+    std::vector<std::pair<std::size_t, std::size_t>> sorted;
+    std::vector<Bitmap> labels;
+  };
+
+  void add(Food const &food, std::size_t position) {
+    add(food_, food.calories(), food.label_id(), position);
+  }
+  void add(Drink const &drink, std::size_t position) {
+    add(drinks_, drink.volume(), drink.label_id(), position);
+  }
+
+  void add(Column &column, std::size_t amount, unsigned label,
+           std::size_t position) {
+    column.sorted.emplace_back(amount, position);
+    if (column.labels.size() <= label)
+      column.labels.resize(label + 1);
+    Bitmap &bitmap = column.labels[label];
+    if (bitmap.empty())
+      bitmap.resize(words_);
+    bitmap[position / 64] |= std::uint64_t{1} << (position % 64);
+  }
+
+  template <typename Label>
+  std::vector<std::size_t> query(Column const &column, std::size_t min,
+                                 std::size_t max,
+                                 std::initializer_list<Label> labels) const {
+    std::vector<Bitmap const *> bitmaps;
+    for (unsigned label : labels)
+      if (label < column.labels.size() && !column.labels[label].empty())
+        bitmaps.push_back(&column.labels[label]);
+    if (labels.size() != 0 && bitmaps.empty())
+      return {};
+
+    std::vector<std::size_t> positions;
+    auto it = std::lower_bound(column.sorted.begin(), column.sorted.end(),
+                               std::make_pair(min, std::size_t{0}));
+    for (; it != column.sorted.end() && it->first <= max; ++it) {
+      std::size_t position = it->second;
+      bool match = bitmaps.empty();
+      for (auto const *bitmap : bitmaps)
+        match = match || ((*bitmap)[position / 64] >> (position % 64)) & 1;
+      if (match)
+        positions.push_back(position);
+    }
+    return positions;
+  }
+
+  std::size_t words_;
+  Column food_;
+  Column drinks_;
+};
+
+/**
+ * EN: Small helpers shared by the visitors below: a number as decimal text,
+ * formatted with \c std::to_chars into a buffer on the stack (unlike
+ * \c std::ostream, it never consults the locale), and a number as a varint
+ * (little-endian base-128: 7 bits per byte, with the high bit set on all but
+ * the last byte).
+ */
+std::string_view format_decimal(char (&digits)[20], std::size_t value) {
+  auto [end, error] = std::to_chars(digits, digits + sizeof(digits), value);
+  return {digits, static_cast<std::size_t>(end - digits)};
+}
+
+void append_decimal(std::string &out, std::size_t value) {
+  char digits[20];
+  out.append(format_decimal(digits, value));
+}
+
+char *put_varint(char *out, std::size_t value) {
+  while (value >= 0x80) {
+    *out++ = static_cast<char>(value | 0x80);
+    value >>= 7;
+  }
+  *out++ = static_cast<char>(value);
+  return out;
+}
+
+void append_varint(std::string &out, std::size_t value) {
+  char bytes[10];
+  out.append(bytes, put_varint(bytes, value) - bytes);
+}
+
 /**
  * EN: Serialiser Visitor Functor
  *
  * This basic \c Serialiser class has non-canonical operator() overloads
- * which take the different \c Item types as input arguments, define lambdas to
- * perform a rudimentary conversion of the data to compressed/minified JSON
- * using the public API of the classes, and then print out the converted result
- * to some \c std::ostream by invoking the lambdas. Each \c Item has its own
- * unique overloaded operator() definition, which makes this class a prime
- * candidate for the Strategy Design Pattern e.g. different JSON specifications.
+ * which take the different \c Item types as input arguments, perform a
+ * rudimentary conversion of the data to compressed/minified JSON using the
+ * public API of the classes, and print out the converted result piece by piece
+ * to some \c std::ostream. Each \c Item has its own unique overloaded
+ * operator() definition, which makes this class a prime candidate for the
+ * Strategy Design Pattern e.g. different JSON specifications.
  */
 class Serialiser {
 public:
@@ -157,22 +412,18 @@ public:
 
 public:
   auto operator()(Food const &food) const {
-
-    auto to_json = [&](auto f) {
-      return R"({"item":"food","name":")" + f.name() + R"(","calories":")" +
-             std::to_string(f.calories()) + R"(kcal","label":")" + f.label() +
-             R"("})";
-    };
-
-    os_ << to_json(food);
+    char digits[20];
+    auto calories = format_decimal(digits, food.calories());
+    os_ << R"({"item":"food","name":")" << food.name() << R"(","calories":")";
+    os_.write(calories.data(), calories.size());
+    os_ << R"(kcal","label":")" << food.label() << R"("})";
   }
   auto operator()(Drink const &drink) const {
-    auto to_json = [&](auto d) {
-      return R"({"item":"drink","name":")" + d.name() + R"(","volume":")" +
-             std::to_string(d.volume()) + R"(ml","label":")" + d.label() +
-             R"("})";
-    };
-    os_ << to_json(drink);
+    char digits[20];
+    auto volume = format_decimal(digits, drink.volume());
+    os_ << R"({"item":"drink","name":")" << drink.name() << R"(","volume":")";
+    os_.write(volume.data(), volume.size());
+    os_ << R"(ml","label":")" << drink.label() << R"("})";
   }
   /* ... */
 
@@ -180,6 +431,321 @@ private:
   std::ostream &os_{std::cout};
 };
 
+/**
+ * EN: Buffer Serialiser Visitor Functor
+ *
+ * The same JSON, appended straight to a caller-owned \c std::string instead of
+ * going through \c std::ostream. Literals and views are copied in as they are
+ * and numbers are formatted with \c std::to_chars on the stack, so once the
+ * buffer has grown to size (and it keeps its capacity when cleared between
+ * uses) serialising an item allocates nothing at all.
+ */
+class BufferSerialiser {
+public:
+  explicit BufferSerialiser(std::string &out) : out_{out} {}
+
+public:
+  void operator()(Food const &food) const {
+    out_.append(R"({"item":"food","name":")");
+    out_.append(food.name());
+    out_.append(R"(","calories":")");
+    append_decimal(out_, food.calories());
+    out_.append(R"(kcal","label":")");
+    out_.append(food.label());
+    out_.append(R"("})");
+  }
+  void operator()(Drink const &drink) const {
+    out_.append(R"({"item":"drink","name":")");
+    out_.append(drink.name());
+    out_.append(R"(","volume":")");
+    append_decimal(out_, drink.volume());
+    out_.append(R"(ml","label":")");
+    out_.append(drink.label());
+    out_.append(R"("})");
+  }
+  /* ... */
+
+private:
+  std::string &out_;
+};
+
+/**
+ * EN: Binary Serialiser Visitor Functor
+ *
+ * A compact alternative to JSON for services talking to each other, in the
+ * spirit of MessagePack and CBOR. Every item is written as
+ *
+ *     kind (1 byte) | label (1 byte) | amount (varint) | name size (varint) | name
+ *
+ * where the kind is the index of the type in the \c Item variant and the label
+ * is its numeric value. Numbers are therefore not formatted as text at all,
+ * and the names can later be read in place.
+ */
+class BinarySerialiser {
+public:
+  explicit BinarySerialiser(std::string &out) : out_{out} {}
+
+public:
+  void operator()(Food const &food) const {
+    write_item(alternative_index_v<Food, Item>, food.label_id(), food.calories(), food.name());
+  }
+  void operator()(Drink const &drink) const {
+    write_item(alternative_index_v<Drink, Item>, drink.label_id(), drink.volume(), drink.name());
+  }
+  /* ... */
+
+private:
+  void write_item(std::size_t kind, unsigned label, std::size_t amount,
+                  std::string_view name) const {
+    out_.push_back(static_cast<char>(kind));
+    out_.push_back(static_cast<char>(label));
+    append_varint(out_, amount);
+    append_varint(out_, name.size());
+    out_.append(name);
+  }
+
+  std::string &out_;
+};
+
+/**
+ * EN: Declarative Field Schemas
+ *
+ * Writing an overload of every visitor for every \c Item type does not scale
+ * to many item types. Instead, each type can declare its fields once, in a
+ * \c Schema specialisation: the name of the item, and for every field its
+ * name and the accessor that reads it (plus a unit for numbers, and for enums
+ * the accessor that spells them out). The accessors are template arguments,
+ * so they are part of each field's type rather than values looked up at run
+ * time. Generic visitors then expand the field list with a fold expression,
+ * and the code they produce for a type is the same straight-line sequence of
+ * inlined calls one would write by hand.
+ */
+template <auto Get, auto Text = nullptr> struct Field {
+  static constexpr auto get = Get;
+  static constexpr auto text = Text;
+  std::string_view name;
+  std::string_view unit;
+};
+
+template <auto Get>
+constexpr auto field(std::string_view name, std::string_view unit = {}) {
+  return Field<Get>{name, unit};
+}
+
+template <auto Get, auto Text>
+constexpr auto enum_field(std::string_view name) {
+  return Field<Get, Text>{name, {}};
+}
+
+template <typename T> struct Schema;
+
+template <> struct Schema<Food> {
+  static constexpr std::string_view name{"food"};
+  static constexpr auto fields =
+      std::make_tuple(field<&Food::name>("name"),
+                      field<&Food::calories>("calories", "kcal"),
+                      enum_field<&Food::label_id, &Food::label>("label"));
+};
+
+template <> struct Schema<Drink> {
+  static constexpr std::string_view name{"drink"};
+  static constexpr auto fields =
+      std::make_tuple(field<&Drink::name>("name"),
+                      field<&Drink::volume>("volume", "ml"),
+                      enum_field<&Drink::label_id, &Drink::label>("label"));
+};
+
+/* ... */
+
+template <typename T>
+inline constexpr std::size_t field_count_v =
+    std::tuple_size_v<std::decay_t<decltype(Schema<T>::fields)>>;
+
+template <typename T, typename Function>
+constexpr void for_each_field(Function &&function) {
+  std::apply([&](auto const &...fields) { (..., function(fields)); },
+             Schema<T>::fields);
+}
+
+/**
+ * EN: The literal JSON between the values of a \c T, joined at compile time:
+ * \c key<0>() is everything up to the first value, e.g.
+ * \c {"item":"food","name":" and \c key<I>() everything between value
+ * \c I-1 and value \c I, e.g. \c kcal","label":" after the calories. The
+ * last one closes the item.
+ */
+template <typename T> class JsonKeys {
+public:
+  template <std::size_t I> static constexpr std::string_view key() {
+    return {keys_.chars.data() + keys_.ends[I],
+            keys_.ends[I + 1] - keys_.ends[I]};
+  }
+
+private:
+  // EN: Calls \c piece with the index of the key and each piece of its text.
+  template <typename Piece> static constexpr void pieces(Piece &&piece) {
+    std::size_t i{0};
+    std::string_view unit{};
+    piece(i, R"({"item":")");
+    piece(i, Schema<T>::name);
+    std::apply(
+        [&](auto const &...fields) {
+          (..., (piece(i, unit), piece(i, R"(",")"), piece(i, fields.name),
+                 piece(i, R"(":")"), unit = fields.unit, ++i));
+        },
+        Schema<T>::fields);
+    piece(i, unit);
+    piece(i, R"("})");
+  }
+
+  static constexpr std::size_t size_ = [] {
+    std::size_t size{0};
+    pieces([&](std::size_t, std::string_view text) { size += text.size(); });
+    return size;
+  }();
+
+  struct Keys {
+    std::array<char, size_> chars{};
+    std::array<std::size_t, field_count_v<T> + 2> ends{};
+  };
+
+  static constexpr Keys keys_ = [] {
+    Keys keys{};
+    std::size_t size{0};
+    pieces([&](std::size_t i, std::string_view text) {
+      for (char c : text)
+        keys.chars[size++] = c;
+      keys.ends[i + 1] = size;
+    });
+    return keys;
+  }();
+};
+
+/**
+ * EN: Generated JSON Visitor: the same output as the \c Serialiser, for any
+ * type that has a \c Schema. Between the values it appends the \c JsonKeys
+ * of the type, so it makes as few appends as the \c BufferSerialiser.
+ */
+class SchemaJsonSerialiser {
+public:
+  explicit SchemaJsonSerialiser(std::string &out) : out_{out} {}
+
+  template <typename T> void operator()(T const &item) const {
+    write(item, std::make_index_sequence<field_count_v<T>>{});
+  }
+
+private:
+  template <typename T, std::size_t... I>
+  void write(T const &item, std::index_sequence<I...>) const {
+    out_.append(JsonKeys<T>::template key<0>());
+    (..., (write_value(item, std::get<I>(Schema<T>::fields)),
+           out_.append(JsonKeys<T>::template key<I + 1>())));
+  }
+
+  template <typename T, typename F>
+  void write_value(T const &item, F const &field) const {
+    if constexpr (!std::is_null_pointer_v<decltype(field.text)>) {
+      out_.append((item.*field.text)());
+    } else {
+      auto value = (item.*field.get)();
+      if constexpr (std::is_convertible_v<decltype(value), std::string_view>)
+        out_.append(value);
+      else
+        append_decimal(out_, value);
+    }
+  }
+
+  std::string &out_;
+};
+
+/**
+ * EN: Generated Binary Visitor: the same bytes as the \c BinarySerialiser, for
+ * any type that has a \c Schema. After the kind of the item, the fields are
+ * written by width rather than in schema order: enums first as single bytes,
+ * then numbers as varints, then strings prefixed with their size. That is the
+ * layout \c BinaryReader expects, so \c deserialise_binary reads it back.
+ *
+ * Everything but the contents of the strings is first put together in a
+ * buffer on the stack, whose size the schema bounds at compile time, so an
+ * item with one string takes two appends.
+ */
+class SchemaBinarySerialiser {
+public:
+  explicit SchemaBinarySerialiser(std::string &out) : out_{out} {}
+
+  template <typename T> void operator()(T const &item) const {
+    // EN: The kind, then at most a 10-byte varint per field.
+    char head[1 + 10 * field_count_v<T>];
+    char *end = head;
+    *end++ = static_cast<char>(alternative_index_v<T, Item>);
+    for_each_field<T>([&](auto const &field) {
+      if constexpr (is_enum_v<decltype(field)>)
+        *end++ = static_cast<char>((item.*field.get)());
+    });
+    for_each_field<T>([&](auto const &field) {
+      if constexpr (!is_enum_v<decltype(field)> &&
+                    !is_string_v<T, decltype(field)>)
+        end = put_varint(end, static_cast<std::size_t>((item.*field.get)()));
+    });
+    for_each_field<T>([&](auto const &field) {
+      if constexpr (is_string_v<T, decltype(field)>) {
+        std::string_view value = (item.*field.get)();
+        end = put_varint(end, value.size());
+        out_.append(head, end - head);
+        out_.append(value);
+        end = head;
+      }
+    });
+    if (end != head)
+      out_.append(head, end - head);
+  }
+
+private:
+  template <typename F>
+  static constexpr bool is_enum_v =
+      !std::is_null_pointer_v<decltype(std::decay_t<F>::text)>;
+  template <typename T, typename F>
+  static constexpr bool is_string_v = std::is_convertible_v<
+      std::invoke_result_t<decltype(std::decay_t<F>::get), T const &>,
+      std::string_view>;
+
+  std::string &out_;
+};
+
+/**
+ * EN: Generated Hash Visitor: folds every field of every visited item into a
+ * 64-bit FNV-1a hash, e.g. to tell whether a \c Menu has changed.
+ */
+class SchemaHasher {
+public:
+  explicit SchemaHasher(std::uint64_t &hash) : hash_{hash} {}
+
+  template <typename T> void operator()(T const &item) const {
+    mix(alternative_index_v<T, Item>);
+    for_each_field<T>([&](auto const &field) {
+      auto value = (item.*field.get)();
+      if constexpr (std::is_convertible_v<decltype(value), std::string_view>) {
+        mix(value.size());
+        for (char c : std::string_view{value})
+          mix_byte(static_cast<unsigned char>(c));
+      } else {
+        mix(static_cast<std::size_t>(value));
+      }
+    });
+  }
+
+private:
+  void mix_byte(unsigned char byte) const {
+    hash_ = (hash_ ^ byte) * 1099511628211ULL;
+  }
+  void mix(std::size_t value) const {
+    for (unsigned i = 0; i < sizeof(value); ++i)
+      mix_byte(static_cast<unsigned char>(value >> (8 * i)));
+  }
+
+  std::uint64_t &hash_;
+};
+
 /* ... */
 
 /**
@@ -212,6 +778,688 @@ void serialise(Menu const &menu, std::ostream &os = std::cout) {
   os << R"(]})";
 }
 
+/**
+ * EN: The same loop with the \c BufferSerialiser, appending the whole \c Menu
+ * to \c out.
+ */
+void serialise(Menu::const_iterator first, Menu::const_iterator last,
+               std::string &out) {
+  for (auto it = first; it != last; ++it) {
+    if (it != first)
+      out.push_back(',');
+    std::visit(BufferSerialiser{out}, *it);
+  }
+}
+
+void serialise(Menu const &menu, std::string &out) {
+  out.append(R"({"menu":[)");
+  serialise(menu.begin(), menu.end(), out);
+  out.append(R"(]})");
+}
+
+/**
+ * EN: Since every \c Item is serialised independently of the others, a large
+ * \c Menu can be split into contiguous chunks which are serialised on separate
+ * threads, each into a buffer of its own, by the very same visitor. Stitching
+ * the buffers together in order, with a comma between each pair, gives output
+ * byte-identical to the sequential \c serialise.
+ */
+void serialise_parallel(Menu const &menu, std::string &out,
+                        std::size_t threads = std::thread::hardware_concurrency()) {
+  threads = std::max<std::size_t>(1, std::min(threads, menu.size()));
+  std::size_t const chunk = (menu.size() + threads - 1) / threads;
+  std::vector<std::string> buffers(threads);
+  std::vector<std::thread> workers;
+  for (std::size_t i = 0; i < threads; ++i) {
+    workers.emplace_back([&, i] {
+      auto first = menu.begin() + std::min(i * chunk, menu.size());
+      auto last = menu.begin() + std::min((i + 1) * chunk, menu.size());
+      serialise(first, last, buffers[i]);
+    });
+  }
+  for (auto &worker : workers)
+    worker.join();
+
+  std::size_t size = out.size() + threads + 16;
+  for (auto const &buffer : buffers)
+    size += buffer.size();
+  out.reserve(size);
+  out.append(R"({"menu":[)");
+  bool first{true};
+  for (auto const &buffer : buffers) {
+    if (buffer.empty())
+      continue;
+    if (!first)
+      out.push_back(',');
+    first = false;
+    out.append(buffer);
+  }
+  out.append(R"(]})");
+}
+
+/**
+ * EN: File Descriptor Sink
+ *
+ * For exports, even the \c std::string buffer is one step too many: the JSON
+ * should go to a file or a pipe as it is produced. The sink keeps a ring of
+ * buffers of a fixed capacity. Items are serialised into the current buffer,
+ * and once it is full the sink moves on to the next one. Full buffers are
+ * handed to the file descriptor several at a time with a single \c writev.
+ *
+ * By default the writes happen on the serialising thread whenever the whole
+ * ring is full. With \c background set, a writer thread takes full buffers
+ * off the ring as soon as they are ready, so that serialising the next items
+ * overlaps with writing the previous ones (double buffering, or more).
+ *
+ * The first failed write is remembered and nothing is written after it, since
+ * the output would have a hole anyway; \c flush reports whether all went well.
+ */
+class FdSink {
+public:
+  explicit FdSink(int fd, std::size_t capacity = 1 << 16,
+                  std::size_t buffers = 8, bool background = false)
+      : fd_{fd}, capacity_{capacity}, buffers_(std::max<std::size_t>(buffers, 2)) {
+    for (auto &buffer : buffers_)
+      buffer.reserve(capacity_);
+    if (background)
+      writer_ = std::thread{[this] { write_in_background(); }};
+  }
+
+  FdSink(FdSink const &) = delete;
+  FdSink &operator=(FdSink const &) = delete;
+
+  ~FdSink() {
+    flush();
+    if (writer_.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock{mutex_};
+        stopping_ = true;
+      }
+      ready_.notify_all();
+      writer_.join();
+    }
+  }
+
+  /**
+   * EN: The buffer to append to. After appending, call \c commit so that the
+   * sink can move on once the buffer is full.
+   */
+  std::string &buffer() noexcept { return buffers_[head_ % buffers_.size()]; }
+
+  void commit() {
+    if (buffer().size() >= capacity_)
+      rotate();
+  }
+
+  /**
+   * EN: Writes out everything appended so far. Returns false if any write has
+   * failed since the sink was created.
+   */
+  bool flush() {
+    if (!buffer().empty())
+      rotate();
+    if (writer_.joinable()) {
+      std::unique_lock<std::mutex> lock{mutex_};
+      written_.wait(lock, [this] { return tail_ == head_; });
+    } else {
+      write_buffers(tail_, head_);
+      tail_ = head_;
+    }
+    return error_ == 0;
+  }
+
+  /**
+   * EN: The \c errno of the first failed write, or 0. Up to date after
+   * \c flush.
+   */
+  int error() const noexcept { return error_; }
+
+private:
+  void rotate() {
+    if (!writer_.joinable()) {
+      if (++head_ - tail_ == buffers_.size()) {
+        write_buffers(tail_, head_);
+        tail_ = head_;
+      }
+      return;
+    }
+    std::unique_lock<std::mutex> lock{mutex_};
+    ++head_;
+    ready_.notify_one();
+    // EN: The next buffer must not still be waiting to be written.
+    written_.wait(lock, [this] { return head_ - tail_ < buffers_.size(); });
+  }
+
+  void write_in_background() {
+    std::unique_lock<std::mutex> lock{mutex_};
+    for (;;) {
+      ready_.wait(lock, [this] { return tail_ != head_ || stopping_; });
+      if (tail_ == head_)
+        return;
+      std::size_t first = tail_, last = head_;
+      lock.unlock();
+      write_buffers(first, last);
+      lock.lock();
+      tail_ = last;
+      written_.notify_all();
+    }
+  }
+
+  /**
+   * EN: Writes the buffers with sequence numbers [first, last) and empties
+   * them, resuming after partial writes.
+   */
+  void write_buffers(std::size_t first, std::size_t last) {
+#ifdef _WIN32
+    for (std::size_t i = first; i != last; ++i) {
+      auto &buffer = buffers_[i % buffers_.size()];
+      for (std::size_t done = 0; error_ == 0 && done < buffer.size();) {
+        int n = _write(fd_, buffer.data() + done,
+                       static_cast<unsigned>(buffer.size() - done));
+        if (n <= 0)
+          error_ = n < 0 ? errno : EIO;
+        else
+          done += n;
+      }
+      buffer.clear();
+    }
+#else
+    std::vector<iovec> iov;
+    for (std::size_t i = first; i != last; ++i) {
+      auto &buffer = buffers_[i % buffers_.size()];
+      iov.push_back({buffer.data(), buffer.size()});
+    }
+    for (std::size_t next = 0; error_ == 0 && next < iov.size();) {
+      ssize_t n = ::writev(fd_, iov.data() + next,
+                           static_cast<int>(std::min<std::size_t>(iov.size() - next, IOV_MAX)));
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0) {
+        error_ = n < 0 ? errno : EIO;
+        break;
+      }
+      auto done = static_cast<std::size_t>(n);
+      while (next < iov.size() && done >= iov[next].iov_len)
+        done -= iov[next++].iov_len;
+      if (done != 0) {
+        iov[next].iov_base = static_cast<char *>(iov[next].iov_base) + done;
+        iov[next].iov_len -= done;
+      }
+    }
+    for (std::size_t i = first; i != last; ++i)
+      buffers_[i % buffers_.size()].clear();
+#endif
+  }
+
+  int fd_;
+  std::size_t capacity_;
+  std::vector<std::string> buffers_;
+  // EN: Sequence numbers: buffers [tail_, head_) are full and waiting to be
+  // written, buffer head_ is being filled.
+  std::size_t head_{0};
+  std::size_t tail_{0};
+  // EN: Only written by the thread doing the writes; \c flush reads it after
+  // the writes it waited for.
+  int error_{0};
+  bool stopping_{false};
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::condition_variable written_;
+  std::thread writer_;
+};
+
+/**
+ * EN: Returns false if writing to the sink's file descriptor failed.
+ */
+bool serialise(Menu const &menu, FdSink &sink) {
+  sink.buffer().append(R"({"menu":[)");
+  for (auto const &item : menu) {
+    if (&item != &menu.front())
+      sink.buffer().push_back(',');
+    std::visit(BufferSerialiser{sink.buffer()}, item);
+    sink.commit();
+  }
+  sink.buffer().append(R"(]})");
+  return sink.flush();
+}
+
+/**
+ * EN: Menu Deserialiser
+ *
+ * The inverse of \c serialise: a single forward pass over the JSON text that
+ * turns every object in the \c "menu" array straight into a \c Food or \c Drink
+ * at the back of the \c Menu. No intermediate tree is built; strings are
+ * handed around as views into the input, and the only allocations are those
+ * of the names stored in the items themselves. Jumping to the end of a string
+ * is done with \c std::memchr, which the standard library implements with
+ * vector instructions on common platforms.
+ *
+ * Fields may come in any order, but every item needs each of its four fields
+ * exactly once; unknown fields make the document invalid, as does anything
+ * else the \c Serialiser would not have written, in which case \c deserialise
+ * returns false and leaves the \c Menu as it was.
+ */
+class MenuParser {
+public:
+  explicit MenuParser(std::string_view json) : json_{json} {}
+
+  bool parse(Menu &menu) {
+    auto const size = menu.size();
+    if (document(menu))
+      return true;
+    menu.erase(menu.begin() + size, menu.end());
+    return false;
+  }
+
+private:
+  static constexpr std::string_view invalid{"\0", 1};
+
+  bool document(Menu &menu) {
+    if (!consume('{') || string() != "menu" || !consume(':') || !consume('['))
+      return false;
+    if (!consume(']')) {
+      do {
+        if (!item(menu))
+          return false;
+      } while (consume(','));
+      if (!consume(']'))
+        return false;
+    }
+    if (!consume('}'))
+      return false;
+    skip_whitespace();
+    return pos_ == json_.size();
+  }
+
+  bool item(Menu &menu) {
+    std::string_view kind, name, amount, label;
+    unsigned seen{0};
+    // EN: Each field may be set once; a repeated key invalidates the item.
+    auto set = [&seen](std::string_view &field, unsigned bit,
+                       std::string_view value) {
+      if (seen & bit)
+        return false;
+      seen |= bit;
+      field = value;
+      return true;
+    };
+    if (!consume('{'))
+      return false;
+    do {
+      std::string_view key = string();
+      if (!consume(':'))
+        return false;
+      std::string_view value = string();
+      bool fresh{false};
+      if (key == "item")
+        fresh = set(kind, 1, value);
+      else if (key == "name")
+        fresh = set(name, 2, value);
+      else if (key == "calories" || key == "volume")
+        fresh = set(amount, 4, value);
+      else if (key == "label")
+        fresh = set(label, 8, value);
+      if (!fresh)
+        return false;
+    } while (consume(','));
+    if (!consume('}') || seen != 0xf)
+      return false;
+
+    std::size_t number{};
+    auto [end, error] =
+        std::from_chars(amount.data(), amount.data() + amount.size(), number);
+    if (error != std::errc{})
+      return false;
+    std::string_view unit = amount.substr(end - amount.data());
+
+    if (kind == "food" && unit == "kcal") {
+      static constexpr std::string_view labels[]{"meat", "fish", "vegetarian",
+                                                 "vegan"};
+      for (unsigned i = 0; i < std::size(labels); ++i) {
+        if (label == labels[i]) {
+          menu.emplace_back(std::in_place_type<Food>, std::string{name}, number,
+                            static_cast<Food::Label>(i));
+          return true;
+        }
+      }
+    } else if (kind == "drink" && unit == "ml") {
+      static constexpr std::string_view labels[]{"alcholic", "hot", "cold"};
+      for (unsigned i = 0; i < std::size(labels); ++i) {
+        if (label == labels[i]) {
+          menu.emplace_back(std::in_place_type<Drink>, std::string{name},
+                            number, static_cast<Drink::Label>(i));
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  void skip_whitespace() {
+    while (pos_ < json_.size() &&
+           (json_[pos_] == ' ' || json_[pos_] == '\n' || json_[pos_] == '\r' ||
+            json_[pos_] == '\t'))
+      ++pos_;
+  }
+
+  bool consume(char c) {
+    skip_whitespace();
+    if (pos_ < json_.size() && json_[pos_] == c) {
+      ++pos_;
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   * EN: Strings written by the \c Serialiser contain no escapes, so a string
+   * is simply everything up to the next quote.
+   */
+  std::string_view string() {
+    if (!consume('"'))
+      return invalid;
+    auto const *begin = json_.data() + pos_;
+    auto const *end = static_cast<char const *>(
+        std::memchr(begin, '"', json_.size() - pos_));
+    if (end == nullptr || std::memchr(begin, '\\', end - begin) != nullptr)
+      return invalid;
+    pos_ += end - begin + 1;
+    return {begin, static_cast<std::size_t>(end - begin)};
+  }
+
+  std::string_view json_;
+  std::size_t pos_{0};
+};
+
+bool deserialise(std::string_view json, Menu &menu) {
+  return MenuParser{json}.parse(menu);
+}
+
+/**
+ * EN: Binary (de)serialisation of the whole \c Menu: the item count as a
+ * varint, followed by the items.
+ */
+void serialise_binary(Menu const &menu, std::string &out) {
+  append_varint(out, menu.size());
+  for (auto const &item : menu)
+    std::visit(BinarySerialiser{out}, item);
+}
+
+/**
+ * EN: Reads items back out of the binary encoding without copying anything:
+ * every \c BinaryItem refers to its name inside the buffer, so a service that
+ * only needs a few fields never pays for building a \c Food or \c Drink.
+ */
+struct BinaryItem {
+  std::size_t kind;
+  unsigned label;
+  std::size_t amount;
+  std::string_view name;
+};
+
+class BinaryReader {
+public:
+  explicit BinaryReader(std::string_view data) : data_{data} {
+    remaining_ = read_varint();
+  }
+
+  std::size_t remaining() const noexcept { return remaining_; }
+
+  /**
+   * EN: False once the data has turned out to be truncated or malformed.
+   */
+  bool ok() const noexcept { return valid_; }
+
+  /**
+   * EN: Returns false once all items have been read or the data is truncated.
+   */
+  bool next(BinaryItem &item) {
+    if (!valid_ || remaining_ == 0)
+      return false;
+    if (data_.size() - pos_ < 2) {
+      valid_ = false;
+      return false;
+    }
+    item.kind = static_cast<unsigned char>(data_[pos_++]);
+    item.label = static_cast<unsigned char>(data_[pos_++]);
+    item.amount = read_varint();
+    std::size_t size = read_varint();
+    if (valid_ && data_.size() - pos_ < size)
+      valid_ = false;
+    if (!valid_)
+      return false;
+    item.name = data_.substr(pos_, size);
+    pos_ += size;
+    --remaining_;
+    return true;
+  }
+
+private:
+  std::size_t read_varint() {
+    std::size_t value{0};
+    for (unsigned shift = 0; pos_ < data_.size() && shift < 64; shift += 7) {
+      auto byte = static_cast<unsigned char>(data_[pos_++]);
+      // EN: The tenth byte only has room for the top bit of a 64-bit value.
+      if (shift == 63 && (byte & 0x7e) != 0)
+        break;
+      value |= static_cast<std::size_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0)
+        return value;
+    }
+    valid_ = false;
+    return 0;
+  }
+
+  std::string_view data_;
+  std::size_t pos_{0};
+  std::size_t remaining_{0};
+  bool valid_{true};
+};
+
+/**
+ * EN: Like \c deserialise, leaves the \c Menu as it was on invalid data.
+ */
+bool deserialise_binary(std::string_view data, Menu &menu) {
+  auto const size = menu.size();
+  BinaryReader reader{data};
+  BinaryItem item;
+  bool valid{true};
+  while (valid && reader.next(item)) {
+    if (item.kind == alternative_index_v<Food, Item> && item.label <= Food::vegan)
+      menu.emplace_back(std::in_place_type<Food>, std::string{item.name},
+                        item.amount, static_cast<Food::Label>(item.label));
+    else if (item.kind == alternative_index_v<Drink, Item> && item.label <= Drink::cold)
+      menu.emplace_back(std::in_place_type<Drink>, std::string{item.name},
+                        item.amount, static_cast<Drink::Label>(item.label));
+    else
+      valid = false;
+  }
+  if (valid && reader.ok() && reader.remaining() == 0)
+    return true;
+  menu.erase(menu.begin() + size, menu.end());
+  return false;
+}
+
+/**
+ * EN: Benchmark
+ *
+ * Times the \c serialise paths and \c deserialise on a large \c Menu made of
+ * copies of \c sample, through the shared \c benchmark::Harness: every timed
+ * body starts from the same state, since the harness runs it once to warm up
+ * (which also grows the reused buffers to size) and then repeatedly. Finally,
+ * a visitor that only reads every item is run over the \c Menu and over the
+ * same items in a \c ColumnarMenu. Operations are items. Consistency checks
+ * report to \c std::cerr, so that \c --json output stays valid.
+ */
+void benchmark_menu(benchmark::Harness &harness, Menu const &sample,
+                    std::size_t size) {
+  Menu menu;
+  menu.reserve(size);
+  for (std::size_t i = 0; i < size; ++i)
+    menu.push_back(sample[i % sample.size()]);
+
+  harness.Run("ostream", size, [&] {
+    std::ostringstream os;
+    serialise(menu, os);
+    benchmark::DoNotOptimize(os);
+  });
+  std::string out;
+  harness.Run("buffer", size, [&] {
+    out.clear();
+    serialise(menu, out);
+  });
+  std::string parallel;
+  harness.Run("parallel", size, [&] {
+    parallel.clear();
+    serialise_parallel(menu, parallel);
+  });
+  if (parallel != out)
+    std::cerr << "parallel output differs from sequential output\n";
+
+  Menu parsed;
+  parsed.reserve(size);
+  harness.Run("deserialise", size, [&] {
+    parsed.clear();
+    if (!deserialise(out, parsed))
+      std::cerr << "deserialise failed\n";
+  });
+  std::string round_trip;
+  serialise(parsed, round_trip);
+  if (round_trip != out)
+    std::cerr << "round trip output differs from original output\n";
+
+#ifdef _WIN32
+  char const *null_device = "NUL";
+  int fd = _open(null_device, _O_WRONLY | _O_BINARY);
+#else
+  char const *null_device = "/dev/null";
+  int fd = ::open(null_device, O_WRONLY);
+#endif
+  harness.Run("ostream to file", size, [&] {
+    std::ofstream file{null_device};
+    serialise(menu, file);
+  });
+  harness.Run("fd sink", size, [&] {
+    FdSink sink{fd};
+    if (!serialise(menu, sink))
+      std::cerr << "fd sink: " << std::strerror(sink.error()) << '\n';
+  });
+  harness.Run("fd sink, background writes", size, [&] {
+    FdSink sink{fd, 1 << 16, 8, true};
+    if (!serialise(menu, sink))
+      std::cerr << "fd sink: " << std::strerror(sink.error()) << '\n';
+  });
+#ifdef _WIN32
+  _close(fd);
+#else
+  ::close(fd);
+#endif
+
+  std::string binary;
+  harness.Run("binary serialise", size, [&] {
+    binary.clear();
+    serialise_binary(menu, binary);
+  });
+  Menu binary_parsed;
+  binary_parsed.reserve(size);
+  harness.Run("binary deserialise", size, [&] {
+    binary_parsed.clear();
+    if (!deserialise_binary(binary, binary_parsed))
+      std::cerr << "binary deserialise failed\n";
+  });
+  harness.Run("binary read in place", size, [&] {
+    BinaryReader reader{binary};
+    BinaryItem item;
+    std::size_t amounts{0};
+    while (reader.next(item))
+      amounts += item.amount;
+    benchmark::DoNotOptimize(amounts);
+  });
+  round_trip.clear();
+  serialise(binary_parsed, round_trip);
+  if (round_trip != out)
+    std::cerr << "binary round trip differs from original output\n";
+  std::cerr << "binary size: " << binary.size() << " bytes, JSON size: "
+            << out.size() << " bytes\n";
+
+  std::string schema_json;
+  schema_json.reserve(out.size());
+  harness.Run("schema JSON serialise", size, [&] {
+    schema_json.clear();
+    schema_json.append(R"({"menu":[)");
+    for (auto const &item : menu) {
+      if (&item != &menu.front())
+        schema_json.push_back(',');
+      std::visit(SchemaJsonSerialiser{schema_json}, item);
+    }
+    schema_json.append(R"(]})");
+  });
+  if (schema_json != out)
+    std::cerr << "schema JSON differs from Serialiser output\n";
+  std::string schema_binary;
+  schema_binary.reserve(binary.size());
+  harness.Run("schema binary serialise", size, [&] {
+    schema_binary.clear();
+    append_varint(schema_binary, menu.size());
+    for (auto const &item : menu)
+      std::visit(SchemaBinarySerialiser{schema_binary}, item);
+  });
+  if (schema_binary != binary)
+    std::cerr << "schema binary differs from BinarySerialiser output\n";
+  harness.Run("schema hash", size, [&] {
+    std::uint64_t hash{14695981039346656037ULL};
+    for (auto const &item : menu)
+      std::visit(SchemaHasher{hash}, item);
+    benchmark::DoNotOptimize(hash);
+  });
+
+  ColumnarMenu columns;
+  for (auto const &item : menu)
+    columns.push_back(item);
+  std::size_t totals[3]{};
+  auto total = [](std::size_t &sum) {
+    return [&sum](auto const &item) {
+      if constexpr (std::is_same_v<std::decay_t<decltype(item)>, Food>)
+        sum += item.calories();
+      else
+        sum += item.volume();
+    };
+  };
+  harness.Run("visit variant", size, [&] {
+    totals[0] = 0;
+    for (auto const &item : menu)
+      std::visit(total(totals[0]), item);
+  });
+  harness.Run("visit columnar by type", size, [&] {
+    totals[1] = 0;
+    columns.visit_by_type(total(totals[1]));
+  });
+  harness.Run("visit columnar in order", size, [&] {
+    totals[2] = 0;
+    columns.visit_in_order(total(totals[2]));
+  });
+  if (totals[0] != totals[1] || totals[0] != totals[2])
+    std::cerr << "columnar visits differ from variant visits\n";
+
+  std::size_t matches[2]{};
+  harness.Run("query vegan food 200-400kcal by scan", size, [&] {
+    matches[0] = 0;
+    for (auto const &item : menu)
+      if (auto const *food = std::get_if<Food>(&item))
+        matches[0] += food->label_id() == Food::vegan &&
+                      food->calories() >= 200 && food->calories() <= 400;
+  });
+  std::optional<MenuIndex> index;
+  harness.Run("build index", size, [&] {
+    index.emplace(menu);
+  });
+  harness.Run("query vegan food 200-400kcal by index", size, [&] {
+    matches[1] = index->food(200, 400, {Food::vegan}).size();
+  });
+  if (matches[0] != matches[1])
+    std::cerr << "index query differs from scan\n";
+}
+
 /* ... */
 
 /**
@@ -222,8 +1470,11 @@ void serialise(Menu const &menu, std::ostream &os = std::cout) {
  * instances is also drastically simplified by the value semantics. Finally, the
  * neat \c serialise method can be called with the \c Menu input argument to
  * demonstrate Modern C++17 Visitor Design Pattern in action.
+ *
+ * Run with \c --benchmark [items] [--json] [--repetitions N] to time the
+ * serialisers on a large menu, of 10 million items unless given.
  */
-int main() {
+int main(int argc, char *argv[]) {
 
   Menu menu;
   menu.reserve(8);
@@ -238,5 +1489,13 @@ int main() {
   menu.emplace_back(Drink{"Kola", 355, Drink::Label::cold});
   /* ... */
 
+  if (argc > 1 && std::string_view{argv[1]} == "--benchmark") {
+    benchmark::Harness harness{argc, argv};
+    bool const sized = argc > 2 && argv[2][0] >= '0' && argv[2][0] <= '9';
+    benchmark_menu(harness, menu,
+                   sized ? std::strtoull(argv[2], nullptr, 10) : 10000000);
+    return harness.Finish();
+  }
+
   serialise(menu);
 }
\ No newline at end of file